@@ -0,0 +1,68 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static double BenchNow(void)
+{
+	struct timespec t;
+	timespec_get(&t, TIME_UTC);
+	return (double)t.tv_sec + 1e-9*(double)t.tv_nsec;
+}
+
+static unsigned BenchRandom(unsigned *state)
+{
+	// xorshift32
+	unsigned x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return *state = x;
+}
+
+// Builds a machine generated looking expression of roughly termCount terms,
+// with indentation, line breaks and nested parentheses.
+static char *BenchGenerateExpression(int termCount, unsigned seed)
+{
+	static const char ops[] = "+-*/";
+
+	size_t capacity = (size_t)termCount * 48 + 64;
+	char *result = malloc(capacity);
+	size_t len = 0;
+	int depth = 0;
+
+	for (int i = 0; i < termCount; ++i)
+	{
+		unsigned r = BenchRandom(&seed);
+
+		if (i > 0)
+		{
+			len += snprintf(result + len, capacity - len, " %c", ops[r % 4]);
+			if (r % 7 == 0) len += snprintf(result + len, capacity - len, "\n        ");
+			else result[len++] = ' ';
+		}
+
+		if (r % 5 == 0 && depth < 8)
+		{
+			result[len++] = '(';
+			++depth;
+		}
+
+		len += snprintf(result + len, capacity - len, "%u.%u", r % 1000, (r >> 10) % 100);
+
+		if (r % 3 == 0 && depth > 0)
+		{
+			result[len++] = ')';
+			--depth;
+		}
+	}
+
+	while (depth-- > 0) result[len++] = ')';
+	result[len] = '\0';
+
+	return result;
+}
+
+#endif
@@ -0,0 +1,110 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "../src/tokenizer.h"
+#include "../src/parser.h"
+#include "../src/bytecode.h"
+#include "../src/columns.h"
+
+#define ROW_COUNT 100000
+#define ITERATIONS 20
+
+static const char formula[] = "(price * quantity - discount) * (1 + tax) / quantity + price * price / 1000";
+
+static void BenchKernel(const char *name, ColumnsKernel kernel, const Program *program,
+	const double *const *columns, double *results, double expected)
+{
+	if (ColumnsUseKernel(kernel) != kernel)
+	{
+		printf("%-28s not supported\n", name);
+		return;
+	}
+
+	double best = 1e30;
+	for (int i = 0; i < ITERATIONS; ++i)
+	{
+		double start = BenchNow();
+		RunProgramColumns(program, columns, results, ROW_COUNT);
+		double elapsed = BenchNow() - start;
+
+		if (elapsed < best) best = elapsed;
+	}
+
+	printf("%-28s %10.2f ns/row\n", name, best / ROW_COUNT * 1e9);
+
+	if (results[ROW_COUNT - 1] != expected)
+	{
+		fprintf(stderr, "Result mismatch: %g, expected %g\n", results[ROW_COUNT - 1], expected);
+		exit(1);
+	}
+}
+
+int main(void)
+{
+	TokenStream ts = TokenStreamFromCStr(formula);
+	Parser parser;
+	ParserInit(&parser, &ts);
+	Expr *expr = ParseExpression(&parser, 0, (Token){TOK_INPUT_END});
+	Program program = CompileExpr(expr);
+
+	int variableCount = program.variableCount;
+	double *values = malloc(variableCount * ROW_COUNT * sizeof(*values));
+	const double **columns = malloc(variableCount * sizeof(*columns));
+	double *results = malloc(ROW_COUNT * sizeof(*results));
+
+	unsigned seed = 777;
+	for (int slot = 0; slot < variableCount; ++slot)
+	{
+		columns[slot] = values + slot * ROW_COUNT;
+		for (int row = 0; row < ROW_COUNT; ++row)
+		{
+			values[slot * ROW_COUNT + row] = 1 + BenchRandom(&seed) % 1000 / 10.0;
+		}
+	}
+
+	// Row by row, for comparison.
+	double variables[16];
+	volatile double sink = 0;
+
+	double best = 1e30;
+	for (int i = 0; i < ITERATIONS; ++i)
+	{
+		double start = BenchNow();
+		for (int row = 0; row < ROW_COUNT; ++row)
+		{
+			for (int slot = 0; slot < variableCount; ++slot) variables[slot] = columns[slot][row];
+			sink = EvalExpr(expr, variables);
+		}
+		double elapsed = BenchNow() - start;
+		if (elapsed < best) best = elapsed;
+	}
+	printf("%d rows, %d variables, %d instructions\n", ROW_COUNT, variableCount, program.codeLen);
+	printf("%-28s %10.2f ns/row\n", "tree (EvalExpr per row)", best / ROW_COUNT * 1e9);
+
+	best = 1e30;
+	for (int i = 0; i < ITERATIONS; ++i)
+	{
+		double start = BenchNow();
+		for (int row = 0; row < ROW_COUNT; ++row)
+		{
+			for (int slot = 0; slot < variableCount; ++slot) variables[slot] = columns[slot][row];
+			sink = RunProgram(&program, variables);
+		}
+		double elapsed = BenchNow() - start;
+		if (elapsed < best) best = elapsed;
+	}
+	printf("%-28s %10.2f ns/row\n", "vm (RunProgram per row)", best / ROW_COUNT * 1e9);
+
+	double expected = sink;
+	BenchKernel("columns (scalar)", COLUMNS_KERNEL_SCALAR, &program, columns, results, expected);
+	BenchKernel("columns (SSE2)", COLUMNS_KERNEL_SSE2, &program, columns, results, expected);
+	BenchKernel("columns (AVX2)", COLUMNS_KERNEL_AVX2, &program, columns, results, expected);
+
+	free(results);
+	free(columns);
+	free(values);
+	ProgramFree(&program);
+	ParserRelease(&parser);
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,92 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "../src/decimal.h"
+
+#define LITERAL_COUNT 1000000
+#define ITERATIONS 5
+
+typedef struct Span_t
+{
+	const char *start;
+	const char *end;
+} Span;
+
+// Literals shaped like our inputs: mostly short integers and decimals, some
+// with long fractions.
+static char *GenerateCorpus(Span *spans, int count)
+{
+	char *corpus = malloc((size_t)count * 40);
+	size_t len = 0;
+	unsigned seed = 7;
+
+	for (int i = 0; i < count; ++i)
+	{
+		unsigned r = BenchRandom(&seed);
+		const char *start = corpus + len;
+
+		switch (r % 4)
+		{
+			case 0: len += sprintf(corpus + len, "%u", r % 10000); break;
+			case 1: len += sprintf(corpus + len, "%u.%u", r % 1000, (r >> 12) % 1000); break;
+			case 2: len += sprintf(corpus + len, "0.%09u%06u", BenchRandom(&seed) % 1000000000, r % 1000000); break;
+			case 3: len += sprintf(corpus + len, "%u%u.%u", r, BenchRandom(&seed), BenchRandom(&seed)); break;
+		}
+
+		spans[i] = (Span){start, corpus + len};
+		corpus[len++] = ' ';
+	}
+
+	corpus[len] = '\0';
+	return corpus;
+}
+
+int main(void)
+{
+	Span *spans = malloc(LITERAL_COUNT * sizeof(*spans));
+	char *corpus = GenerateCorpus(spans, LITERAL_COUNT);
+	size_t corpusLen = strlen(corpus);
+
+	volatile double sink = 0;
+	double sum = 0;
+
+	double best = 1e30;
+	for (int iteration = 0; iteration < ITERATIONS; ++iteration)
+	{
+		double start = BenchNow();
+		sum = 0;
+		for (int i = 0; i < LITERAL_COUNT; ++i) sum += strtod(spans[i].start, NULL);
+		double elapsed = BenchNow() - start;
+		if (elapsed < best) best = elapsed;
+	}
+	sink = sum;
+	double strtodSum = sum;
+
+	printf("%d literals, %zu bytes\n", LITERAL_COUNT, corpusLen);
+	printf("%-28s %8.1f Mliterals/s %8.1f MB/s\n", "strtod", LITERAL_COUNT / best * 1e-6, corpusLen / best * 1e-6);
+
+	best = 1e30;
+	for (int iteration = 0; iteration < ITERATIONS; ++iteration)
+	{
+		double start = BenchNow();
+		sum = 0;
+		for (int i = 0; i < LITERAL_COUNT; ++i) sum += ParseDecimal(spans[i].start, spans[i].end);
+		double elapsed = BenchNow() - start;
+		if (elapsed < best) best = elapsed;
+	}
+	sink = sum;
+
+	printf("%-28s %8.1f Mliterals/s %8.1f MB/s\n", "ParseDecimal", LITERAL_COUNT / best * 1e-6, corpusLen / best * 1e-6);
+
+	if (sink != strtodSum)
+	{
+		fprintf(stderr, "Result mismatch\n");
+		return 1;
+	}
+
+	free(corpus);
+	free(spans);
+	return 0;
+}
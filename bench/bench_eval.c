@@ -0,0 +1,101 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "../src/tokenizer.h"
+#include "../src/parser.h"
+#include "../src/ast.h"
+#include "../src/bytecode.h"
+#include "../src/jit.h"
+
+#define TERM_COUNT 200
+#define EVALUATIONS 20000
+
+int main(void)
+{
+	char *input = BenchGenerateExpression(TERM_COUNT, 4321);
+
+	TokenStream ts = TokenStreamFromCStr(input);
+	Parser parser;
+	ParserInit(&parser, &ts);
+	Expr *expr = ParseExpression(&parser, 0, (Token){TOK_INPUT_END});
+
+	if (!expr || expr->type == EXPR_PARSE_ERROR)
+	{
+		fprintf(stderr, "Benchmark input did not parse\n");
+		return 1;
+	}
+
+	volatile double sink = 0;
+
+	double start = BenchNow();
+	for (int i = 0; i < EVALUATIONS; ++i) sink = EvalExpr(expr, NULL);
+	double treeSeconds = BenchNow() - start;
+	double treeResult = sink;
+
+	PostOrder order = {0};
+	FlattenExpr(expr, &order);
+
+	start = BenchNow();
+	for (int i = 0; i < EVALUATIONS; ++i) sink = EvalPostOrder(&order, NULL);
+	double postOrderSeconds = BenchNow() - start;
+	double postOrderResult = sink;
+
+	Ast ast = {0};
+	AstFromExpr(&ast, expr);
+
+	start = BenchNow();
+	for (int i = 0; i < EVALUATIONS; ++i) sink = EvalAst(&ast, NULL);
+	double astSeconds = BenchNow() - start;
+	double astResult = sink;
+
+	Program program = CompileExpr(expr);
+
+	start = BenchNow();
+	for (int i = 0; i < EVALUATIONS; ++i) sink = RunProgram(&program, NULL);
+	double vmSeconds = BenchNow() - start;
+	double vmResult = sink;
+
+	printf("%d terms, %d instructions, %d evaluations\n", TERM_COUNT, program.codeLen, EVALUATIONS);
+	printf("%-28s %10.1f ns/eval\n", "tree (EvalExpr)", treeSeconds / EVALUATIONS * 1e9);
+	printf("%-28s %10.1f ns/eval\n", "post order (EvalPostOrder)", postOrderSeconds / EVALUATIONS * 1e9);
+	printf("%-28s %10.1f ns/eval\n", "compact ast (EvalAst)", astSeconds / EVALUATIONS * 1e9);
+	printf("%-28s %10.1f ns/eval\n", "bytecode (RunProgram)", vmSeconds / EVALUATIONS * 1e9);
+
+	if (treeResult != vmResult || treeResult != postOrderResult || treeResult != astResult)
+	{
+		fprintf(stderr, "Result mismatch: tree %g, post order %g, ast %g, vm %g\n", treeResult, postOrderResult, astResult, vmResult);
+		return 1;
+	}
+
+	JitCode code;
+	if (JitCompile(expr, &code))
+	{
+		start = BenchNow();
+		for (int i = 0; i < EVALUATIONS; ++i) sink = code.fn(NULL);
+		double jitSeconds = BenchNow() - start;
+
+		printf("%-28s %10.1f ns/eval\n", "machine code (JitCompile)", jitSeconds / EVALUATIONS * 1e9);
+
+		if (sink != treeResult)
+		{
+			fprintf(stderr, "Result mismatch: tree %g, jit %g\n", treeResult, sink);
+			return 1;
+		}
+		JitFree(&code);
+	}
+	else
+	{
+		printf("%-28s not supported\n", "machine code (JitCompile)");
+	}
+
+	printf("%-28s %10.1f bytes/node\n", "tree (Expr)", (double)sizeof(Expr));
+	printf("%-28s %10.1f bytes/node\n", "compact ast (Ast)", (double)AstBytes(&ast) / ast.count);
+
+	AstFree(&ast);
+	PostOrderFree(&order);
+	ProgramFree(&program);
+	ParserRelease(&parser);
+	free(input);
+	return 0;
+}
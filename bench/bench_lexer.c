@@ -0,0 +1,194 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "../src/tokenizer.h"
+#include "../src/scan.h"
+#include "../src/cpu.h"
+#include "../src/parlex.h"
+
+#define LINE_COUNT 200000
+#define ITERATIONS 5
+
+// One short term per line behind deep indentation, like our generated files.
+static char *GenerateIndentedInput(int lineCount)
+{
+	size_t capacity = (size_t)lineCount * 96 + 1;
+	char *result = malloc(capacity);
+	size_t len = 0;
+	unsigned seed = 99;
+
+	for (int i = 0; i < lineCount; ++i)
+	{
+		unsigned r = BenchRandom(&seed);
+		int indent = 16 + r % 48;
+		memset(result + len, ' ', indent);
+		len += indent;
+		len += snprintf(result + len, capacity - len, "%s%u.%u\n", i ? "+ " : "", r % 100000, (r >> 8) % 1000);
+	}
+
+	result[len] = '\0';
+	return result;
+}
+
+// Many distinct variable names, each used a few times.
+static char *GenerateIdentifierInput(int termCount, int nameCount)
+{
+	static const char ops[] = "+-*/";
+
+	size_t capacity = (size_t)termCount * 24 + 1;
+	char *result = malloc(capacity);
+	size_t len = 0;
+	unsigned seed = 7;
+
+	for (int i = 0; i < termCount; ++i)
+	{
+		unsigned r = BenchRandom(&seed);
+		if (i > 0) len += snprintf(result + len, capacity - len, " %c ", ops[r % 4]);
+		len += snprintf(result + len, capacity - len, "measurement_%u", (r >> 4) % nameCount);
+	}
+
+	return result;
+}
+
+// Short names, numbers and operators with no whitespace between them, so
+// nearly every byte goes through the dispatch in NextToken.
+static char *GenerateDenseInput(int termCount)
+{
+	static const char ops[] = "+-*/^";
+
+	size_t capacity = (size_t)termCount * 16 + 1;
+	char *result = malloc(capacity);
+	size_t len = 0;
+	unsigned seed = 3;
+
+	for (int i = 0; i < termCount; ++i)
+	{
+		unsigned r = BenchRandom(&seed);
+		if (i > 0) result[len++] = ops[r % 5];
+		if (r & 0x100) len += snprintf(result + len, capacity - len, "(%c%u)", 'a' + r % 26, (r >> 12) % 10);
+		else len += snprintf(result + len, capacity - len, "%u", (r >> 12) % 1000);
+	}
+
+	return result;
+}
+
+static void BenchIdentifiers(const char *name, bool identViews, const char *input, size_t inputLen)
+{
+	double best = 1e30;
+	for (int i = 0; i < ITERATIONS; ++i)
+	{
+		Scope scope = {0};
+		TokenStream ts = TokenStreamFromCStr(input);
+		ts.scope = &scope;
+		ts.identViews = identViews;
+
+		double start = BenchNow();
+		while (NextToken(&ts).type != TOK_INPUT_END) {}
+		double elapsed = BenchNow() - start;
+
+		ScopeFree(&scope);
+		if (elapsed < best) best = elapsed;
+	}
+
+	printf("%-28s %8.1f MB/s\n", name, inputLen / best * 1e-6);
+}
+
+static void BenchKernel(const char *name, ScanKernel kernel, const char *input, size_t inputLen)
+{
+	if (ScanUseKernel(kernel) != kernel)
+	{
+		printf("%-28s not supported\n", name);
+		return;
+	}
+
+	double best = 1e30;
+	for (int i = 0; i < ITERATIONS; ++i)
+	{
+		TokenStream ts = TokenStreamFromCStr(input);
+
+		double start = BenchNow();
+		while (NextToken(&ts).type != TOK_INPUT_END) {}
+		double elapsed = BenchNow() - start;
+
+		if (elapsed < best) best = elapsed;
+	}
+
+	printf("%-28s %8.1f MB/s\n", name, inputLen / best * 1e-6);
+}
+
+// LexTokens against LexTokensParallel on the same input, into one buffer.
+static void BenchParallel(const char *name, ThreadPool *pool, const char *input, size_t inputLen)
+{
+	TokenBuffer buffer = {0};
+	double best = 1e30;
+
+	for (int i = 0; i < ITERATIONS; ++i)
+	{
+		Scope scope = {0};
+		TokenStream ts = TokenStreamFromCStr(input);
+		ts.scope = &scope;
+		ts.identViews = true;
+
+		double start = BenchNow();
+		if (pool) LexTokensParallel(&ts, &buffer, pool);
+		else LexTokens(&ts, &buffer);
+		double elapsed = BenchNow() - start;
+
+		ScopeFree(&scope);
+		if (elapsed < best) best = elapsed;
+	}
+
+	TokenBufferFree(&buffer);
+	printf("%-28s %8.1f MB/s\n", name, inputLen / best * 1e-6);
+}
+
+int main(void)
+{
+	char *input = GenerateIndentedInput(LINE_COUNT);
+	size_t inputLen = strlen(input);
+
+	printf("%d indented lines, %zu bytes\n", LINE_COUNT, inputLen);
+	BenchKernel("lex (scalar scan)", SCAN_KERNEL_SCALAR, input, inputLen);
+	BenchKernel("lex (SSE2 scan)", SCAN_KERNEL_SSE2, input, inputLen);
+	BenchKernel("lex (AVX2 scan)", SCAN_KERNEL_AVX2, input, inputLen);
+
+	free(input);
+
+	char *identifiers = GenerateIdentifierInput(LINE_COUNT * 5, 100000);
+	size_t identifiersLen = strlen(identifiers);
+
+	printf("%d identifiers of 100000 names, %zu bytes\n", LINE_COUNT * 5, identifiersLen);
+	BenchIdentifiers("lex names (copies)", false, identifiers, identifiersLen);
+	BenchIdentifiers("lex names (views)", true, identifiers, identifiersLen);
+
+	free(identifiers);
+
+	// Parallel lexing splits at newlines, so it gets the indented lines.
+	char *lines = GenerateIndentedInput(LINE_COUNT * 5);
+	size_t linesLen = strlen(lines);
+	ThreadPool pool;
+	int threadCount = CpuCount();
+	if (!PoolInit(&pool, threadCount)) PoolInit(&pool, threadCount = 1);
+
+	char name[64];
+	snprintf(name, sizeof(name), "lex parallel (%d threads)", threadCount);
+
+	printf("%d indented lines, %zu bytes\n", LINE_COUNT * 5, linesLen);
+	BenchParallel("lex (LexTokens)", NULL, lines, linesLen);
+	BenchParallel(name, &pool, lines, linesLen);
+
+	PoolRelease(&pool);
+	free(lines);
+
+	char *dense = GenerateDenseInput(LINE_COUNT * 5);
+	size_t denseLen = strlen(dense);
+
+	printf("%d dense terms, %zu bytes\n", LINE_COUNT * 5, denseLen);
+	BenchIdentifiers("lex dense (views)", true, dense, denseLen);
+
+	free(dense);
+	return 0;
+}
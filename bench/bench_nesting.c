@@ -0,0 +1,80 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "../src/tokenizer.h"
+#include "../src/parser.h"
+
+#define MAX_DEPTH 1000000
+#define ITERATIONS 3
+
+typedef struct Shape_t
+{
+	const char *name;
+	const char *open; // Repeated depth times, then "1", then close depth times
+	const char *close;
+} Shape;
+
+static const Shape shapes[] = {
+	{"parentheses -(-(...))", "-(", ")"},
+	{"right nested (1+(1+...))", "(1+", ")"},
+	{"exponent chain 2^2^...", "2^", ""},
+};
+
+static char *GenerateNesting(const Shape *shape, int depth)
+{
+	size_t openLen = strlen(shape->open);
+	size_t closeLen = strlen(shape->close);
+	char *result = malloc(depth * (openLen + closeLen) + 2);
+	char *at = result;
+
+	for (int i = 0; i < depth; ++i, at += openLen) memcpy(at, shape->open, openLen);
+	*at++ = '1';
+	for (int i = 0; i < depth; ++i, at += closeLen) memcpy(at, shape->close, closeLen);
+	*at = '\0';
+
+	return result;
+}
+
+int main(void)
+{
+	printf("%-28s %10s %12s %10s\n", "", "depth", "tokens", "ns/token");
+
+	for (size_t s = 0; s < sizeof(shapes)/sizeof(*shapes); ++s)
+	{
+		// Linear time shows as a flat ns/token across depths.
+		for (int depth = MAX_DEPTH / 100; depth <= MAX_DEPTH; depth *= 10)
+		{
+			char *input = GenerateNesting(&shapes[s], depth);
+			double best = 1e30;
+			size_t tokenCount = 0;
+
+			for (int i = 0; i < ITERATIONS; ++i)
+			{
+				TokenStream ts = TokenStreamFromCStr(input);
+				Parser parser;
+
+				double start = BenchNow();
+				ParserInit(&parser, &ts);
+				Expr *expr = ParseExpression(&parser, 0, (Token){TOK_INPUT_END});
+				double elapsed = BenchNow() - start;
+
+				if (!expr || expr->type == EXPR_PARSE_ERROR)
+				{
+					fprintf(stderr, "Benchmark input did not parse: %s\n", shapes[s].name);
+					return 1;
+				}
+
+				tokenCount = parser.tokens.count;
+				ParserRelease(&parser);
+				if (elapsed < best) best = elapsed;
+			}
+
+			printf("%-28s %10d %12zu %10.2f\n", shapes[s].name, depth, tokenCount, best / tokenCount * 1e9);
+			free(input);
+		}
+	}
+
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,178 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "../src/tokenizer.h"
+#include "../src/parser.h"
+#include "../src/pipeline.h"
+
+#define TERM_COUNT 1000000
+#define ITERATIONS 5
+
+// A formula over nameCount variables, each mentioned many times.
+static char *GenerateVariableExpression(int termCount, int nameCount, unsigned seed)
+{
+	static const char ops[] = "+-*/";
+
+	size_t capacity = (size_t)termCount * 16 + 1;
+	char *result = malloc(capacity);
+	size_t len = 0;
+
+	for (int i = 0; i < termCount; ++i)
+	{
+		unsigned r = BenchRandom(&seed);
+		if (i > 0) len += snprintf(result + len, capacity - len, " %c ", ops[r % 4]);
+		len += snprintf(result + len, capacity - len, "var_%u", (r >> 4) % nameCount);
+	}
+
+	return result;
+}
+
+static double BenchLexParse(const char *input, long *tokenCount)
+{
+	double best = 1e30;
+
+	for (int i = 0; i < ITERATIONS; ++i)
+	{
+		TokenStream ts = TokenStreamFromCStr(input);
+		Parser parser;
+
+		double start = BenchNow();
+		ParserInit(&parser, &ts);
+		Expr *expr = ParseExpression(&parser, 0, (Token){TOK_INPUT_END});
+		double elapsed = BenchNow() - start;
+
+		if (!expr || expr->type == EXPR_PARSE_ERROR)
+		{
+			fprintf(stderr, "Benchmark input did not parse\n");
+			exit(1);
+		}
+
+		*tokenCount = (long)parser.tokens.count - 1;
+		ParserRelease(&parser);
+		if (elapsed < best) best = elapsed;
+	}
+
+	return best;
+}
+
+// Same as BenchLexParse with the lexer on a thread of its own. Also returns
+// the counters of the best run.
+static double BenchPipelined(const char *input, long *tokenCount, PipelineStats *bestStats)
+{
+	double best = 1e30;
+
+	for (int i = 0; i < ITERATIONS; ++i)
+	{
+		TokenStream ts = TokenStreamFromCStr(input);
+		Parser parser = {0};
+		Pipeline pipeline;
+		PipelineStats stats;
+
+		double start = BenchNow();
+		if (!PipelineStart(&pipeline, &parser, &ts))
+		{
+			fprintf(stderr, "Could not start the lexer thread\n");
+			exit(1);
+		}
+		Expr *expr = ParseExpression(&parser, 0, (Token){TOK_INPUT_END});
+		PipelineFinish(&pipeline, &stats);
+		double elapsed = BenchNow() - start;
+
+		if (!expr || expr->type == EXPR_PARSE_ERROR)
+		{
+			fprintf(stderr, "Benchmark input did not parse\n");
+			exit(1);
+		}
+
+		*tokenCount = (long)stats.tokens - 1;
+		ParserRelease(&parser);
+		if (elapsed < best)
+		{
+			best = elapsed;
+			*bestStats = stats;
+		}
+	}
+
+	return best;
+}
+
+int main(void)
+{
+	char *input = BenchGenerateExpression(TERM_COUNT, 1234);
+
+	long tokenCount = 0;
+	double best = 1e30;
+
+	for (int i = 0; i < ITERATIONS; ++i)
+	{
+		TokenStream ts = TokenStreamFromCStr(input);
+		Scope scope = {0};
+		ts.scope = &scope;
+
+		double start = BenchNow();
+		long count = 0;
+		while (NextToken(&ts).type != TOK_INPUT_END) ++count;
+		double elapsed = BenchNow() - start;
+
+		ScopeFree(&scope);
+
+		tokenCount = count;
+		if (elapsed < best) best = elapsed;
+	}
+
+	printf("%-28s %10ld tokens %8.2f Mtokens/s\n", "lex (NextToken)", tokenCount, tokenCount / best * 1e-6);
+
+	TokenBuffer buffer = {0};
+	best = 1e30;
+
+	for (int i = 0; i < ITERATIONS; ++i)
+	{
+		TokenStream ts = TokenStreamFromCStr(input);
+
+		double start = BenchNow();
+		LexTokens(&ts, &buffer);
+		double elapsed = BenchNow() - start;
+
+		if (elapsed < best) best = elapsed;
+	}
+
+	// Tokens and their side arrays, against the Token NextToken returns.
+	size_t bufferBytes = buffer.count * sizeof(*buffer.tokens)
+		+ buffer.numberCount * sizeof(*buffer.numbers)
+		+ buffer.identCount * sizeof(*buffer.idents);
+
+	printf("%-28s %10ld tokens %8.2f Mtokens/s\n", "lex (LexTokens)", tokenCount, tokenCount / best * 1e-6);
+	printf("%-28s %10.1f bytes/token (Token is %zu)\n", "token buffer", (double)bufferBytes / buffer.count, sizeof(Token));
+	TokenBufferFree(&buffer);
+
+	best = BenchLexParse(input, &tokenCount);
+	printf("%-28s %10ld tokens %8.2f Mtokens/s\n", "lex + parse", tokenCount, tokenCount / best * 1e-6);
+
+	PipelineStats stats;
+	best = BenchPipelined(input, &tokenCount, &stats);
+	printf("%-28s %10ld tokens %8.2f Mtokens/s\n", "lex + parse (pipelined)", tokenCount, tokenCount / best * 1e-6);
+
+	// Lexing hidden behind parsing: the time lexing took, less the time the
+	// parser spent waiting for it.
+	double overlap = stats.lexSeconds - stats.waitSeconds;
+	printf("%-28s %10zu batches, lexer waited %zu, parser waited %zu (%.1f ms); %.1f of %.1f ms lexing overlapped\n",
+		"  pipeline counters", stats.batches, stats.lexerWaits, stats.parserWaits,
+		stats.waitSeconds * 1e3, (overlap > 0 ? overlap : 0) * 1e3, stats.lexSeconds * 1e3);
+
+	static const int nameCounts[] = {5, 5000};
+	for (size_t i = 0; i < sizeof(nameCounts)/sizeof(*nameCounts); ++i)
+	{
+		char *variableInput = GenerateVariableExpression(TERM_COUNT, nameCounts[i], 4321);
+		best = BenchLexParse(variableInput, &tokenCount);
+
+		char name[64];
+		snprintf(name, sizeof(name), "lex + parse (%d variables)", nameCounts[i]);
+		printf("%-28s %10ld tokens %8.2f Mtokens/s\n", name, tokenCount, tokenCount / best * 1e-6);
+		free(variableInput);
+	}
+
+	free(input);
+	return 0;
+}
@@ -0,0 +1,131 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "../src/tokenizer.h"
+#include "../src/parser.h"
+#include "../src/bytecode.h"
+#include "../src/jit.h"
+
+#define EVALUATIONS 1000000
+
+// The same polynomial twice: with literal exponents, which are strength
+// reduced, and with exponents read from variables, which go through pow().
+static const char constantFormula[] = "3*x^3 - 2*x^2 + x^4/7 - x^0.5 + x^-1";
+static const char variableFormula[] = "3*x^a - 2*x^b + x^c/7 - x^d + x^e";
+
+static const struct { const char *name; double value; } exponents[] = {
+	{"a", 3}, {"b", 2}, {"c", 4}, {"d", 0.5}, {"e", -1},
+};
+
+typedef struct Timings_t
+{
+	double tree, vm, jit;
+	double result;
+} Timings;
+
+static Timings BenchFormula(const char *formula)
+{
+	TokenStream ts = TokenStreamFromCStr(formula);
+	Parser parser;
+	ParserInit(&parser, &ts);
+	Expr *expr = ParseExpression(&parser, 0, (Token){TOK_INPUT_END});
+
+	if (!expr || expr->type == EXPR_PARSE_ERROR)
+	{
+		fprintf(stderr, "Benchmark input did not parse: %s\n", formula);
+		exit(1);
+	}
+
+	double variables[8] = {0};
+	for (int i = 0; i < (int)(sizeof(exponents)/sizeof(*exponents)); ++i)
+	{
+		int slot = ScopeFind(&parser.scope, exponents[i].name, strlen(exponents[i].name));
+		if (slot >= 0) variables[slot] = exponents[i].value;
+	}
+	int xSlot = ScopeFind(&parser.scope, "x", 1);
+
+	Timings timings = {0};
+	volatile double sink = 0;
+	double sum = 0;
+
+	double start = BenchNow();
+	for (int i = 0; i < EVALUATIONS; ++i)
+	{
+		variables[xSlot] = 1 + (i & 15) * 0.125;
+		sink = EvalExpr(expr, variables);
+	}
+	timings.tree = BenchNow() - start;
+	timings.result = sink;
+
+	Program program = CompileExpr(expr);
+
+	start = BenchNow();
+	for (int i = 0; i < EVALUATIONS; ++i)
+	{
+		variables[xSlot] = 1 + (i & 15) * 0.125;
+		sink = RunProgram(&program, variables);
+	}
+	timings.vm = BenchNow() - start;
+	sum += sink;
+
+	JitCode code;
+	timings.jit = -1;
+	if (JitCompile(expr, &code))
+	{
+		start = BenchNow();
+		for (int i = 0; i < EVALUATIONS; ++i)
+		{
+			variables[xSlot] = 1 + (i & 15) * 0.125;
+			sink = code.fn(variables);
+		}
+		timings.jit = BenchNow() - start;
+		sum += sink;
+		JitFree(&code);
+	}
+
+	if (sum != timings.result * (timings.jit < 0 ? 1 : 2))
+	{
+		fprintf(stderr, "Result mismatch between engines: %s\n", formula);
+		exit(1);
+	}
+
+	ProgramFree(&program);
+	ParserRelease(&parser);
+	return timings;
+}
+
+static void PrintRow(const char *name, double constantSeconds, double variableSeconds)
+{
+	if (constantSeconds < 0 || variableSeconds < 0)
+	{
+		printf("%-28s not supported\n", name);
+		return;
+	}
+	printf("%-28s %10.1f %10.1f ns/eval %6.2fx\n", name,
+		constantSeconds / EVALUATIONS * 1e9, variableSeconds / EVALUATIONS * 1e9,
+		variableSeconds / constantSeconds);
+}
+
+int main(void)
+{
+	Timings constant = BenchFormula(constantFormula);
+	Timings variable = BenchFormula(variableFormula);
+
+	printf("%s, %d evaluations\n", constantFormula, EVALUATIONS);
+	printf("%-28s %10s %10s\n", "", "constant", "pow()");
+	PrintRow("tree (EvalExpr)", constant.tree, variable.tree);
+	PrintRow("bytecode (RunProgram)", constant.vm, variable.vm);
+	PrintRow("machine code (JitCompile)", constant.jit, variable.jit);
+
+	// Strength reduction may round differently from pow() in the last bit.
+	double difference = constant.result - variable.result;
+	if (difference < 0) difference = -difference;
+	if (difference > 1e-12 * (variable.result < 0 ? -variable.result : variable.result))
+	{
+		fprintf(stderr, "Result mismatch: constant %.17g, pow %.17g\n", constant.result, variable.result);
+		return 1;
+	}
+	return 0;
+}
\ No newline at end of file
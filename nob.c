@@ -9,6 +9,9 @@ static Cmd *cmd = &cmd_;
 #define BUILD "build/"
 #define TESTS "tests/"
 #define RUNNERS TESTS "runners/"
+#define BENCH "bench/"
+
+static bool optimize = false;
 
 void cmd_cc_common(void)
 {
@@ -17,7 +20,7 @@ void cmd_cc_common(void)
     cmd_append(cmd, "-nologo");
     cmd_append(cmd, "-std:c11");
     cmd_append(cmd, "-W4");
-    cmd_append(cmd, "-Od");
+    cmd_append(cmd, optimize ? "-O2" : "-Od");
     cmd_append(cmd, "-Zi");
     cmd_append(cmd, "-D_CRT_SECURE_NO_WARNINGS");
 #else
@@ -25,7 +28,7 @@ void cmd_cc_common(void)
     cmd_append(cmd, "-std=c11");
     cmd_append(cmd, "-Wall");
     cmd_append(cmd, "-Wextra");
-    cmd_append(cmd, "-O0");
+    cmd_append(cmd, optimize ? "-O2" : "-O0");
     cmd_append(cmd, "-ggdb");
 #endif
     // cmd_append(cmd, "/fsanitize=address");
@@ -47,6 +50,36 @@ void cmd_cc_output(const char *output)
 #endif
 }
 
+void cmd_cc_object(const char *source, const char *output)
+{
+    cmd_append(cmd, "-c", source);
+#if defined(_MSC_VER) && !defined(__clang__)
+    cmd_append(cmd, temp_sprintf("/Fo:%s", output));
+#else
+    cmd_append(cmd, "-o", output);
+#endif
+}
+
+// Everything but the command line front end, for embedding through calc.h.
+static const char *library_sources[] = {
+    "arena",
+    "scope",
+    "tokenizer",
+    "scan",
+    "cpu",
+    "pool",
+    "parlex",
+    "decimal",
+    "parser",
+    "pipeline",
+    "ast",
+    "bytecode",
+    "jit",
+    "optimize",
+    "columns",
+    "calc",
+};
+
 int main(int argc, char **argv)
 {
     NOB_GO_REBUILD_URSELF(argc, argv);
@@ -56,6 +89,8 @@ int main(int argc, char **argv)
     bool build = false;
     bool run = false;
     bool test = false;
+    bool bench = false;
+    bool lib = false;
 
     while (argc) {
         char *arg = shift(argv, argc);
@@ -71,6 +106,14 @@ int main(int argc, char **argv)
         else if (strcmp(arg, "run") == 0) {
             run = true;
         }
+
+        else if (strcmp(arg, "bench") == 0) {
+            bench = true;
+        }
+
+        else if (strcmp(arg, "lib") == 0) {
+            lib = true;
+        }
     }
 
     if (build)
@@ -80,8 +123,23 @@ int main(int argc, char **argv)
         cmd_cc_common();
         cmd_append(cmd, "-I..\\src");
         cmd_append(cmd, SRC "calculator.c");
+        cmd_append(cmd, SRC "arena.c");
+        cmd_append(cmd, SRC "scope.c");
         cmd_append(cmd, SRC "tokenizer.c");
+        cmd_append(cmd, SRC "scan.c");
+        cmd_append(cmd, SRC "cpu.c");
+        cmd_append(cmd, SRC "decimal.c");
         cmd_append(cmd, SRC "parser.c");
+        cmd_append(cmd, SRC "pipeline.c");
+        cmd_append(cmd, SRC "ast.c");
+        cmd_append(cmd, SRC "bytecode.c");
+        cmd_append(cmd, SRC "jit.c");
+        cmd_append(cmd, SRC "optimize.c");
+        cmd_append(cmd, SRC "input.c");
+        cmd_append(cmd, SRC "columns.c");
+        cmd_append(cmd, SRC "table.c");
+        cmd_append(cmd, SRC "pool.c");
+        cmd_append(cmd, SRC "parlex.c");
         cmd_cc_output(BUILD "calculator.exe");
         cmd_append(cmd, "-lm");
 
@@ -98,19 +156,111 @@ int main(int argc, char **argv)
         }
     }
 
+    if (lib)
+    {
+        if (!mkdir_if_not_exists(BUILD)) return 1;
+        if (!mkdir_if_not_exists(BUILD "obj/")) return 1;
+
+        optimize = true;
+
+        Cmd archive = {0};
+#if defined(_MSC_VER) && !defined(__clang__)
+        cmd_append(&archive, "lib", "-nologo", "/OUT:" BUILD "calc.lib");
+#else
+        cmd_append(&archive, "ar", "rcs", BUILD "libcalc.a");
+#endif
+
+        for (size_t i = 0; i < ARRAY_LEN(library_sources); ++i)
+        {
+            const char *object = temp_sprintf(BUILD "obj/%s.o", library_sources[i]);
+
+            cmd_cc_common();
+            cmd_cc_object(temp_sprintf(SRC "%s.c", library_sources[i]), object);
+            if (!cmd_run(cmd)) return 1;
+
+            cmd_append(&archive, object);
+        }
+
+        if (!cmd_run(&archive)) return 1;
+
+        optimize = false;
+    }
+
     if (test)
     {
         if (!mkdir_if_not_exists(RUNNERS)) return 1;
 
+        const char *test_arena_exe = RUNNERS "test_arena.test.exe";
+        const char *test_scan_exe = RUNNERS "test_scan.test.exe";
+        const char *test_decimal_exe = RUNNERS "test_decimal.test.exe";
+        const char *test_input_exe = RUNNERS "test_input.test.exe";
         const char *test_tokenizer_exe = RUNNERS "test_tokenizer.test.exe";
+        const char *test_parlex_exe = RUNNERS "test_parlex.test.exe";
         const char *test_parser_exe = RUNNERS "test_parser.test.exe";
+        const char *test_pipeline_exe = RUNNERS "test_pipeline.test.exe";
+        const char *test_ast_exe = RUNNERS "test_ast.test.exe";
+        const char *test_bytecode_exe = RUNNERS "test_bytecode.test.exe";
+        const char *test_columns_exe = RUNNERS "test_columns.test.exe";
+        const char *test_table_exe = RUNNERS "test_table.test.exe";
+        const char *test_pool_exe = RUNNERS "test_pool.test.exe";
+        const char *test_scope_exe = RUNNERS "test_scope.test.exe";
+        const char *test_jit_exe = RUNNERS "test_jit.test.exe";
+        const char *test_optimize_exe = RUNNERS "test_optimize.test.exe";
+        const char *test_calc_exe = RUNNERS "test_calc.test.exe";
 
         static const char *test_input_paths[] = {
+            SRC "arena.c",
+            SRC "arena.h",
+            SRC "ast.c",
+            SRC "ast.h",
+            SRC "bytecode.c",
+            SRC "bytecode.h",
+            SRC "calc.c",
+            SRC "calc.h",
+            SRC "columns.c",
+            SRC "columns.h",
+            SRC "cpu.c",
+            SRC "cpu.h",
+            SRC "decimal.c",
+            SRC "decimal.h",
+            SRC "input.c",
+            SRC "input.h",
+            SRC "jit.c",
+            SRC "jit.h",
+            SRC "optimize.c",
+            SRC "optimize.h",
+            SRC "parlex.c",
+            SRC "parlex.h",
             SRC "parser.c",
             SRC "parser.h",
+            SRC "pipeline.c",
+            SRC "pipeline.h",
+            SRC "pool.c",
+            SRC "pool.h",
+            SRC "scan.c",
+            SRC "scan.h",
+            SRC "scope.c",
+            SRC "scope.h",
+            SRC "table.c",
+            SRC "table.h",
             SRC "tokenizer.c",
             SRC "tokenizer.h",
+            TESTS "test_arena.c",
+            TESTS "test_ast.c",
+            TESTS "test_bytecode.c",
+            TESTS "test_calc.c",
+            TESTS "test_columns.c",
+            TESTS "test_decimal.c",
+            TESTS "test_input.c",
+            TESTS "test_jit.c",
+            TESTS "test_optimize.c",
+            TESTS "test_parlex.c",
             TESTS "test_parser.c",
+            TESTS "test_pipeline.c",
+            TESTS "test_pool.c",
+            TESTS "test_scan.c",
+            TESTS "test_scope.c",
+            TESTS "test_table.c",
             TESTS "test_tokenizer.c",
         };
 
@@ -118,30 +268,263 @@ int main(int argc, char **argv)
         {
             nob_log(INFO, "Rebuilding tests");
             append_test();
+            cmd_append(cmd, SRC "arena.c");
+            cmd_append(cmd, TESTS "test_arena.c");
+            cmd_cc_output(test_arena_exe);
+            if (!cmd_run(cmd)) return 1;
+
+            append_test();
+            cmd_append(cmd, SRC "scan.c");
+            cmd_append(cmd, SRC "cpu.c");
+            cmd_append(cmd, TESTS "test_scan.c");
+            cmd_cc_output(test_scan_exe);
+            if (!cmd_run(cmd)) return 1;
+
+            append_test();
+            cmd_append(cmd, SRC "decimal.c");
+            cmd_append(cmd, TESTS "test_decimal.c");
+            cmd_cc_output(test_decimal_exe);
+            cmd_append(cmd, "-lm");
+            if (!cmd_run(cmd)) return 1;
+
+            append_test();
+            cmd_append(cmd, SRC "input.c");
+            cmd_append(cmd, TESTS "test_input.c");
+            cmd_cc_output(test_input_exe);
+            if (!cmd_run(cmd)) return 1;
+
+            append_test();
+            cmd_append(cmd, SRC "table.c");
+            cmd_append(cmd, SRC "decimal.c");
+            cmd_append(cmd, TESTS "test_table.c");
+            cmd_cc_output(test_table_exe);
+            cmd_append(cmd, "-lm");
+            if (!cmd_run(cmd)) return 1;
+
+            append_test();
+            cmd_append(cmd, SRC "pool.c");
+            cmd_append(cmd, TESTS "test_pool.c");
+            cmd_cc_output(test_pool_exe);
+            if (!cmd_run(cmd)) return 1;
+
+            append_test();
+            cmd_append(cmd, SRC "arena.c");
+            cmd_append(cmd, SRC "scope.c");
+            cmd_append(cmd, TESTS "test_scope.c");
+            cmd_cc_output(test_scope_exe);
+            if (!cmd_run(cmd)) return 1;
+
+            append_test();
+            cmd_append(cmd, SRC "arena.c");
+            cmd_append(cmd, SRC "scope.c");
             cmd_append(cmd, SRC "tokenizer.c");
+            cmd_append(cmd, SRC "scan.c");
+            cmd_append(cmd, SRC "cpu.c");
+            cmd_append(cmd, SRC "decimal.c");
             cmd_append(cmd, TESTS "test_tokenizer.c");
             cmd_cc_output(test_tokenizer_exe);
             if (!cmd_run(cmd)) return 1;
 
             append_test();
+            cmd_append(cmd, SRC "arena.c");
+            cmd_append(cmd, SRC "scope.c");
             cmd_append(cmd, SRC "tokenizer.c");
+            cmd_append(cmd, SRC "scan.c");
+            cmd_append(cmd, SRC "cpu.c");
+            cmd_append(cmd, SRC "decimal.c");
+            cmd_append(cmd, SRC "pool.c");
+            cmd_append(cmd, SRC "parlex.c");
+            cmd_append(cmd, TESTS "test_parlex.c");
+            cmd_cc_output(test_parlex_exe);
+            if (!cmd_run(cmd)) return 1;
+
+            append_test();
+            cmd_append(cmd, SRC "arena.c");
+            cmd_append(cmd, SRC "scope.c");
+            cmd_append(cmd, SRC "tokenizer.c");
+            cmd_append(cmd, SRC "scan.c");
+            cmd_append(cmd, SRC "cpu.c");
+            cmd_append(cmd, SRC "decimal.c");
             cmd_append(cmd, SRC "parser.c");
             cmd_append(cmd, TESTS "test_parser.c");
             cmd_cc_output(test_parser_exe);
             cmd_append(cmd, "-lm");
 
             if (!cmd_run(cmd)) return 1;
+
+            append_test();
+            cmd_append(cmd, SRC "arena.c");
+            cmd_append(cmd, SRC "scope.c");
+            cmd_append(cmd, SRC "tokenizer.c");
+            cmd_append(cmd, SRC "scan.c");
+            cmd_append(cmd, SRC "cpu.c");
+            cmd_append(cmd, SRC "decimal.c");
+            cmd_append(cmd, SRC "parser.c");
+            cmd_append(cmd, SRC "pipeline.c");
+            cmd_append(cmd, TESTS "test_pipeline.c");
+            cmd_cc_output(test_pipeline_exe);
+            cmd_append(cmd, "-lm");
+            if (!cmd_run(cmd)) return 1;
+
+            append_test();
+            cmd_append(cmd, SRC "arena.c");
+            cmd_append(cmd, SRC "scope.c");
+            cmd_append(cmd, SRC "tokenizer.c");
+            cmd_append(cmd, SRC "scan.c");
+            cmd_append(cmd, SRC "cpu.c");
+            cmd_append(cmd, SRC "decimal.c");
+            cmd_append(cmd, SRC "parser.c");
+            cmd_append(cmd, SRC "ast.c");
+            cmd_append(cmd, TESTS "test_ast.c");
+            cmd_cc_output(test_ast_exe);
+            cmd_append(cmd, "-lm");
+            if (!cmd_run(cmd)) return 1;
+
+            append_test();
+            cmd_append(cmd, SRC "arena.c");
+            cmd_append(cmd, SRC "scope.c");
+            cmd_append(cmd, SRC "tokenizer.c");
+            cmd_append(cmd, SRC "scan.c");
+            cmd_append(cmd, SRC "cpu.c");
+            cmd_append(cmd, SRC "decimal.c");
+            cmd_append(cmd, SRC "parser.c");
+            cmd_append(cmd, SRC "bytecode.c");
+            cmd_append(cmd, TESTS "test_bytecode.c");
+            cmd_cc_output(test_bytecode_exe);
+            cmd_append(cmd, "-lm");
+            if (!cmd_run(cmd)) return 1;
+
+            append_test();
+            for (size_t i = 0; i < ARRAY_LEN(library_sources); ++i)
+            {
+                cmd_append(cmd, temp_sprintf(SRC "%s.c", library_sources[i]));
+            }
+            cmd_append(cmd, TESTS "test_jit.c");
+            cmd_cc_output(test_jit_exe);
+            cmd_append(cmd, "-lm");
+            if (!cmd_run(cmd)) return 1;
+
+            append_test();
+            for (size_t i = 0; i < ARRAY_LEN(library_sources); ++i)
+            {
+                cmd_append(cmd, temp_sprintf(SRC "%s.c", library_sources[i]));
+            }
+            cmd_append(cmd, TESTS "test_optimize.c");
+            cmd_cc_output(test_optimize_exe);
+            cmd_append(cmd, "-lm");
+            if (!cmd_run(cmd)) return 1;
+
+            append_test();
+            for (size_t i = 0; i < ARRAY_LEN(library_sources); ++i)
+            {
+                cmd_append(cmd, temp_sprintf(SRC "%s.c", library_sources[i]));
+            }
+            cmd_append(cmd, TESTS "test_columns.c");
+            cmd_cc_output(test_columns_exe);
+            cmd_append(cmd, "-lm");
+            if (!cmd_run(cmd)) return 1;
+
+            append_test();
+            for (size_t i = 0; i < ARRAY_LEN(library_sources); ++i)
+            {
+                cmd_append(cmd, temp_sprintf(SRC "%s.c", library_sources[i]));
+            }
+            cmd_append(cmd, TESTS "test_calc.c");
+            cmd_cc_output(test_calc_exe);
+            cmd_append(cmd, "-lm");
+            if (!cmd_run(cmd)) return 1;
         }
 
         nob_log(INFO, "Running tests");
 
+        cmd_append(cmd, RUNNERS "test_arena.test.exe");
+        if (!cmd_run(cmd)) return 1;
+
+        cmd_append(cmd, RUNNERS "test_scan.test.exe");
+        if (!cmd_run(cmd)) return 1;
+
+        cmd_append(cmd, RUNNERS "test_decimal.test.exe");
+        if (!cmd_run(cmd)) return 1;
+
+        cmd_append(cmd, RUNNERS "test_input.test.exe");
+        if (!cmd_run(cmd)) return 1;
+
+        cmd_append(cmd, RUNNERS "test_table.test.exe");
+        if (!cmd_run(cmd)) return 1;
+
+        cmd_append(cmd, RUNNERS "test_pool.test.exe");
+        if (!cmd_run(cmd)) return 1;
+
+        cmd_append(cmd, RUNNERS "test_scope.test.exe");
+        if (!cmd_run(cmd)) return 1;
+
         cmd_append(cmd, RUNNERS "test_tokenizer.test.exe");
         if (!cmd_run(cmd)) return 1;
 
+        cmd_append(cmd, RUNNERS "test_parlex.test.exe");
+        if (!cmd_run(cmd)) return 1;
+
         cmd_append(cmd, RUNNERS "test_parser.test.exe");
         if (!cmd_run(cmd)) return 1;
+
+        cmd_append(cmd, RUNNERS "test_pipeline.test.exe");
+        if (!cmd_run(cmd)) return 1;
+
+        cmd_append(cmd, RUNNERS "test_ast.test.exe");
+        if (!cmd_run(cmd)) return 1;
+
+        cmd_append(cmd, RUNNERS "test_bytecode.test.exe");
+        if (!cmd_run(cmd)) return 1;
+
+        cmd_append(cmd, RUNNERS "test_jit.test.exe");
+        if (!cmd_run(cmd)) return 1;
+
+        cmd_append(cmd, RUNNERS "test_optimize.test.exe");
+        if (!cmd_run(cmd)) return 1;
+
+        cmd_append(cmd, RUNNERS "test_columns.test.exe");
+        if (!cmd_run(cmd)) return 1;
+
+        cmd_append(cmd, RUNNERS "test_calc.test.exe");
+        if (!cmd_run(cmd)) return 1;
     }
 
+    if (bench)
+    {
+        if (!mkdir_if_not_exists(BUILD)) return 1;
+
+        static const char *benchmarks[] = {
+            "parser",
+            "eval",
+            "lexer",
+            "decimal",
+            "columns",
+            "pow",
+            "nesting",
+        };
+
+        optimize = true;
+
+        for (size_t i = 0; i < ARRAY_LEN(benchmarks); ++i)
+        {
+            const char *bench_exe = temp_sprintf(BUILD "bench_%s.exe", benchmarks[i]);
+
+            cmd_cc_common();
+            for (size_t j = 0; j < ARRAY_LEN(library_sources); ++j)
+            {
+                cmd_append(cmd, temp_sprintf(SRC "%s.c", library_sources[j]));
+            }
+            cmd_append(cmd, temp_sprintf(BENCH "bench_%s.c", benchmarks[i]));
+            cmd_cc_output(bench_exe);
+            cmd_append(cmd, "-lm");
+            if (!cmd_run(cmd)) return 1;
+
+            cmd_append(cmd, bench_exe);
+            if (!cmd_run(cmd)) return 1;
+        }
+
+        optimize = false;
+    }
 
     return 0;
 }
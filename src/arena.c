@@ -0,0 +1,96 @@
+#include "arena.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_DEFAULT_BLOCK_SIZE (64*1024)
+#define ARENA_ALIGNMENT (_Alignof(max_align_t))
+
+struct ArenaBlock_t
+{
+	ArenaBlock *prev;
+	size_t size;
+	size_t used;
+	_Alignas(max_align_t) unsigned char data[];
+};
+
+static size_t AlignUp(size_t n)
+{
+	return (n + (ARENA_ALIGNMENT - 1)) & ~(ARENA_ALIGNMENT - 1);
+}
+
+static ArenaBlock *NewBlock(Arena *arena, size_t minimumSize)
+{
+	size_t size = arena->minimumBlockSize ? arena->minimumBlockSize : ARENA_DEFAULT_BLOCK_SIZE;
+
+	// Double the block size each time we run out, so the number of blocks
+	// stays logarithmic in the total amount allocated.
+	if (arena->current && size < 2*arena->current->size) size = 2*arena->current->size;
+	if (size < minimumSize) size = minimumSize;
+
+	ArenaBlock *block = malloc(sizeof(*block) + size);
+	if (!block) return NULL;
+
+	block->prev = arena->current;
+	block->size = size;
+	block->used = 0;
+	return block;
+}
+
+void *ArenaAlloc(Arena *arena, size_t size)
+{
+	size = AlignUp(size ? size : 1);
+
+	ArenaBlock *block = arena->current;
+
+	if (!block || block->size - block->used < size)
+	{
+		block = NewBlock(arena, size);
+		assert(block && "Out of memory");
+		arena->current = block;
+	}
+
+	void *result = block->data + block->used;
+	block->used += size;
+	memset(result, 0, size);
+	return result;
+}
+
+char *ArenaStrndup(Arena *arena, const char *chars, size_t len)
+{
+	char *result = ArenaAlloc(arena, len + 1);
+	memcpy(result, chars, len);
+	return result;
+}
+
+void ArenaReset(Arena *arena)
+{
+	ArenaBlock *current = arena->current;
+	if (!current) return;
+
+	// Blocks only grow, so the current one is the largest.
+	ArenaBlock *block = current->prev;
+	while (block)
+	{
+		ArenaBlock *prev = block->prev;
+		free(block);
+		block = prev;
+	}
+
+	current->prev = NULL;
+	current->used = 0;
+}
+
+void ArenaRelease(Arena *arena)
+{
+	ArenaBlock *block = arena->current;
+	while (block)
+	{
+		ArenaBlock *prev = block->prev;
+		free(block);
+		block = prev;
+	}
+	arena->current = NULL;
+}
\ No newline at end of file
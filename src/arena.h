@@ -0,0 +1,29 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+typedef struct ArenaBlock_t ArenaBlock;
+
+// Bump allocator. A zero initialized Arena is ready for use. Blocks grow
+// geometrically, so even a large parse is only a handful of mallocs, and
+// everything is given back at once with ArenaRelease.
+typedef struct Arena_t
+{
+	ArenaBlock *current;
+	size_t minimumBlockSize;
+} Arena;
+
+// Returns zeroed memory aligned for any type.
+void *ArenaAlloc(Arena *arena, size_t size);
+
+// Copies len chars and appends a null terminator.
+char *ArenaStrndup(Arena *arena, const char *chars, size_t len);
+
+// Frees everything allocated so far but keeps the largest block around, so
+// an arena reused for a series of similar jobs stops calling malloc.
+void ArenaReset(Arena *arena);
+
+void ArenaRelease(Arena *arena);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,340 @@
+#include "ast.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static AstIndex AddConstant(Ast *ast, double value)
+{
+	if (ast->constantCount == ast->constantCapacity)
+	{
+		ast->constantCapacity = ast->constantCapacity ? 2*ast->constantCapacity : 16;
+		ast->constants = realloc(ast->constants, ast->constantCapacity * sizeof(*ast->constants));
+		assert(ast->constants && "Out of memory");
+	}
+
+	ast->constants[ast->constantCount] = value;
+	return ast->constantCount++;
+}
+
+static void AddName(Ast *ast, int slot, Ident ident)
+{
+	if (slot >= ast->nameCount)
+	{
+		if (slot >= ast->nameCapacity)
+		{
+			ast->nameCapacity = ast->nameCapacity ? 2*ast->nameCapacity : 16;
+			if (ast->nameCapacity <= slot) ast->nameCapacity = slot + 1;
+			ast->names = realloc(ast->names, ast->nameCapacity * sizeof(*ast->names));
+			assert(ast->names && "Out of memory");
+		}
+		memset(ast->names + ast->nameCount, 0, (slot + 1 - ast->nameCount) * sizeof(*ast->names));
+		ast->nameCount = slot + 1;
+	}
+
+	if (ast->names[slot].chars) return;
+
+	char *chars = malloc(ident.len + 1);
+	assert(chars && "Out of memory");
+	memcpy(chars, ident.chars, ident.len);
+	chars[ident.len] = '\0';
+
+	ast->names[slot] = (Ident){.chars = chars, .len = ident.len};
+}
+
+static void FreeNames(Ast *ast)
+{
+	for (int slot = 0; slot < ast->nameCount; ++slot) free((char *)ast->names[slot].chars);
+	free(ast->names);
+	ast->names = NULL;
+	ast->nameCount = 0;
+	ast->nameCapacity = 0;
+}
+
+void AstFromExpr(Ast *ast, Expr *expr)
+{
+	PostOrder *order = &ast->order;
+	FlattenExpr(expr, order);
+	assert(order->count < UINT32_MAX && "Too many nodes");
+
+	ast->count = 0;
+	ast->constantCount = 0;
+	ast->maxStackDepth = order->maxStackDepth;
+	FreeNames(ast);
+
+	if (order->count > ast->capacity)
+	{
+		ast->capacity = (AstIndex)order->count;
+		ast->nodes = realloc(ast->nodes, ast->capacity * sizeof(*ast->nodes));
+		assert(ast->nodes && "Out of memory");
+	}
+
+	// Indices of the nodes still waiting for their operator, like the values
+	// on the stack during evaluation.
+	AstIndex localStack[64];
+	AstIndex *stack = localStack;
+
+	if (order->maxStackDepth > (int)(sizeof(localStack)/sizeof(*localStack)))
+	{
+		stack = malloc(order->maxStackDepth * sizeof(*stack));
+		assert(stack && "Out of memory");
+	}
+
+	AstIndex *sp = stack - 1;
+
+	for (size_t i = 0; i < order->count; ++i)
+	{
+		Expr *node = order->nodes[i];
+		AstNode compact = {.type = node->type, .flags = node->flags};
+
+		switch (node->type)
+		{
+			case EXPR_NUMBER:
+			{
+				compact.operand = AddConstant(ast, node->as.number);
+			} break;
+
+			case EXPR_VARIABLE:
+			{
+				compact.operand = node->as.variable.slot;
+				AddName(ast, node->as.variable.slot, node->as.variable.ident);
+			} break;
+
+			case EXPR_BINOP:
+			{
+				AstIndex rhs = *sp--;
+				assert(rhs == i - 1);
+				(void)rhs;
+
+				compact.op = node->as.binop.op;
+				compact.operand = *sp--;
+			} break;
+
+			default:
+				assert(0 && "Parse errors have no AST");
+		}
+
+		ast->nodes[ast->count++] = compact;
+		*++sp = (AstIndex)i;
+	}
+
+	assert(sp == stack);
+
+	if (stack != localStack) free(stack);
+}
+
+size_t AstBytes(const Ast *ast)
+{
+	size_t bytes = ast->count * sizeof(*ast->nodes)
+		+ ast->constantCount * sizeof(*ast->constants)
+		+ ast->nameCount * sizeof(*ast->names);
+
+	for (int slot = 0; slot < ast->nameCount; ++slot)
+	{
+		if (ast->names[slot].chars) bytes += ast->names[slot].len + 1;
+	}
+
+	return bytes;
+}
+
+void AstFree(Ast *ast)
+{
+	free(ast->nodes);
+	free(ast->constants);
+	FreeNames(ast);
+	PostOrderFree(&ast->order);
+	*ast = (Ast){0};
+}
+
+static bool AstConstantHalves(const Ast *ast, AstIndex exponent, int *halves)
+{
+	AstNode node = ast->nodes[exponent];
+	if (node.type != EXPR_NUMBER) return false;
+
+	Expr number = {.type = EXPR_NUMBER, .flags = node.flags, .as.number = ast->constants[node.operand]};
+	return ExprConstantHalves(&number, halves);
+}
+
+double EvalAst(const Ast *ast, double *variables)
+{
+	double localStack[64];
+	double *stack = localStack;
+
+	if (ast->maxStackDepth > (int)(sizeof(localStack)/sizeof(*localStack)))
+	{
+		stack = malloc(ast->maxStackDepth * sizeof(*stack));
+		assert(stack && "Out of memory");
+	}
+
+	const AstNode *nodes = ast->nodes;
+	const double *constants = ast->constants;
+
+	// sp points at the top of the stack, one below the first free slot.
+	double *sp = stack - 1;
+
+	for (AstIndex i = 0; i < ast->count; ++i)
+	{
+		AstNode node = nodes[i];
+		double result = 0;
+
+		switch (node.type)
+		{
+			case EXPR_NUMBER:
+			{
+				result = constants[node.operand];
+			} break;
+
+			case EXPR_VARIABLE:
+			{
+				result = variables[node.operand];
+			} break;
+
+			case EXPR_BINOP:
+			{
+				double rresult = *sp--;
+				double lresult = *sp--;
+
+				switch (node.op)
+				{
+					case '+': result = lresult + rresult; break;
+					case '-': result = lresult - rresult; break;
+					case '*': result = lresult * rresult; break;
+					case '/': result = lresult / rresult; break;
+					case '^':
+					{
+						int halves;
+						if (AstConstantHalves(ast, i - 1, &halves)) result = PowHalves(lresult, halves);
+						else result = pow(lresult, rresult);
+					} break;
+					case '=':
+					{
+						result = rresult;
+						variables[nodes[node.operand].operand] = result;
+					} break;
+					default:
+						result = 42.0;
+				}
+			} break;
+
+			default:
+				assert(0 && "Invalid code path!");
+		}
+
+		if (node.flags & EXPR_FLAG_NEGATED)
+		{
+			result = -result;
+		}
+
+		*++sp = result;
+	}
+
+	assert(sp == stack);
+	double result = *sp;
+
+	if (stack != localStack) free(stack);
+
+	return result;
+}
+
+typedef enum
+{
+	PRINT_STYLE_INFIX,
+	PRINT_STYLE_RPN,
+	PRINT_STYLE_S,
+} PrintStyle;
+
+// Prints the same text as the PrintExpr functions, walking the nodes with
+// a stack of indices.
+static void PrintAst(const Ast *ast, PrintStyle style)
+{
+	if (ast->count == 0) return;
+
+	typedef struct { AstIndex index; int visits; } PrintFrame;
+
+	PrintFrame localStack[64];
+	PrintFrame *stack = localStack;
+	size_t capacity = sizeof(localStack)/sizeof(*localStack);
+	size_t depth = 0;
+
+	stack[depth++] = (PrintFrame){ast->count - 1, 0};
+
+	while (depth)
+	{
+		PrintFrame *top = &stack[depth - 1];
+		AstNode node = ast->nodes[top->index];
+		bool negated = node.flags & EXPR_FLAG_NEGATED;
+
+		if (node.type != EXPR_BINOP)
+		{
+			if (negated) printf("-");
+			if (node.type == EXPR_NUMBER) printf("%g", ast->constants[node.operand]);
+			else printf("%s", ast->names[node.operand].chars);
+			--depth;
+			continue;
+		}
+
+		AstIndex next = top->index;
+
+		switch (top->visits++)
+		{
+		case 0:
+			if (style == PRINT_STYLE_INFIX) printf(negated ? "-(" : "(");
+			else if (style == PRINT_STYLE_S) printf(negated ? "(%c -" : "(%c ", node.op);
+			else if (negated) printf("-");
+			next = node.operand;
+			break;
+
+		case 1:
+			if (style == PRINT_STYLE_INFIX) printf(" %c ", node.op);
+			else printf(" ");
+			next = top->index - 1;
+			break;
+
+		default:
+			if (style == PRINT_STYLE_RPN) printf(" %c", node.op);
+			else printf(")");
+			--depth;
+			break;
+		}
+
+		if (next != top->index)
+		{
+			if (depth == capacity)
+			{
+				capacity *= 2;
+				if (stack == localStack)
+				{
+					stack = malloc(capacity * sizeof(*stack));
+					assert(stack && "Out of memory");
+					memcpy(stack, localStack, sizeof(localStack));
+				}
+				else
+				{
+					stack = realloc(stack, capacity * sizeof(*stack));
+					assert(stack && "Out of memory");
+				}
+			}
+			stack[depth++] = (PrintFrame){next, 0};
+		}
+	}
+
+	if (stack != localStack) free(stack);
+}
+
+void PrintAstInfix(const Ast *ast)
+{
+	PrintAst(ast, PRINT_STYLE_INFIX);
+}
+
+void PrintAstRpn(const Ast *ast)
+{
+	PrintAst(ast, PRINT_STYLE_RPN);
+}
+
+void PrintAstS(const Ast *ast)
+{
+	PrintAst(ast, PRINT_STYLE_S);
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+#ifndef AST_H
+#define AST_H
+
+#include <stdint.h>
+
+#include "parser.h"
+
+// A compact copy of an expression tree: one 8 byte node per Expr (which is
+// 32 bytes), all in one array in post order, with numbers and variable
+// names in side tables. Children are 32-bit indices into the array, not
+// pointers. Evaluating and printing read the nodes front to back.
+
+typedef uint32_t AstIndex;
+
+typedef struct AstNode_t
+{
+	uint8_t type;  // ExprType, never EXPR_PARSE_ERROR
+	uint8_t flags; // ExprFlags
+	uint8_t op;    // Operator of a binop
+	uint8_t unused;
+
+	// constants[operand] for a number, the variable slot for a variable and
+	// the index of the left operand for a binop. The right operand of a
+	// binop is always the node just before it.
+	AstIndex operand;
+} AstNode;
+
+typedef struct Ast_t
+{
+	AstNode *nodes; // Root last
+	AstIndex count;
+	AstIndex capacity;
+
+	double *constants;
+	AstIndex constantCount;
+	AstIndex constantCapacity;
+
+	Ident *names; // names[slot], owned; .chars is NULL for slots not used
+	int nameCount;
+	int nameCapacity;
+
+	int maxStackDepth; // Values on the stack at most during evaluation
+
+	PostOrder order; // Scratch of AstFromExpr
+} Ast;
+
+// Replaces the contents of ast with a copy of expr, reusing its memory. The
+// copy does not refer to expr or its parser afterwards.
+void AstFromExpr(Ast *ast, Expr *expr);
+
+// Bytes held by the nodes and side tables, not counting spare capacity.
+size_t AstBytes(const Ast *ast);
+
+void AstFree(Ast *ast);
+
+// Same results as EvalExpr on the expression the AST was made from.
+double EvalAst(const Ast *ast, double *variables);
+
+void PrintAstInfix(const Ast *ast);
+void PrintAstRpn(const Ast *ast);
+void PrintAstS(const Ast *ast);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,248 @@
+#include "bytecode.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+typedef struct Compiler_t
+{
+	Program program;
+	int stackDepth;
+	const char *error; // The first one
+} Compiler;
+
+static void Emit(Compiler *compiler, Opcode opcode, int operand, int stackEffect)
+{
+	Program *program = &compiler->program;
+
+	if (program->codeLen == program->codeCapacity)
+	{
+		program->codeCapacity = program->codeCapacity ? 2*program->codeCapacity : 64;
+		program->code = realloc(program->code, program->codeCapacity * sizeof(*program->code));
+		assert(program->code && "Out of memory");
+	}
+
+	program->code[program->codeLen++] = INSTRUCTION(opcode, operand);
+
+	compiler->stackDepth += stackEffect;
+	assert(compiler->stackDepth >= 1);
+	if (compiler->stackDepth > program->maxStackDepth)
+	{
+		program->maxStackDepth = compiler->stackDepth;
+	}
+}
+
+static int AddConstant(Compiler *compiler, double value)
+{
+	Program *program = &compiler->program;
+
+	if (program->constantCount == PROGRAM_OPERAND_LIMIT)
+	{
+		if (!compiler->error) compiler->error = "Too many constants for the VM";
+		return 0;
+	}
+
+	if (program->constantCount == program->constantCapacity)
+	{
+		program->constantCapacity = program->constantCapacity ? 2*program->constantCapacity : 16;
+		program->constants = realloc(program->constants, program->constantCapacity * sizeof(*program->constants));
+		assert(program->constants && "Out of memory");
+	}
+
+	program->constants[program->constantCount] = value;
+	return program->constantCount++;
+}
+
+static void UseVariable(Compiler *compiler, int slot)
+{
+	if (slot >= PROGRAM_OPERAND_LIMIT)
+	{
+		if (!compiler->error) compiler->error = "Too many variables for the VM";
+		return;
+	}
+
+	if (slot >= compiler->program.variableCount) compiler->program.variableCount = slot + 1;
+}
+
+static Opcode BinaryOpcode(Operator op)
+{
+	switch (op)
+	{
+		case OP_ADD: return OPC_ADD;
+		case OP_MINUS: return OPC_SUB;
+		case OP_MULTIPLY: return OPC_MUL;
+		case OP_DIVIDE: return OPC_DIV;
+		case OP_EXP: return OPC_POW;
+		default:
+			assert(0 && "Invalid code path!");
+			return OPC_ADD;
+	}
+}
+
+// Walks the tree with its own stack, like PrintExpr; each operator is
+// visited before its operands, between them and after them.
+Program CompileExpr(Expr *expr)
+{
+	Compiler compiler = {0};
+
+	typedef struct { Expr *expr; int visits; } CompileFrame;
+
+	CompileFrame *stack = NULL;
+	size_t capacity = 0;
+	size_t depth = 0;
+	Expr *next = expr;
+
+	for (;;)
+	{
+		if (next)
+		{
+			if (depth == capacity)
+			{
+				capacity = capacity ? 2*capacity : 64;
+				stack = realloc(stack, capacity * sizeof(*stack));
+				assert(stack && "Out of memory");
+			}
+			stack[depth++] = (CompileFrame){next, 0};
+			next = NULL;
+		}
+
+		if (depth == 0) break;
+
+		CompileFrame *top = &stack[depth - 1];
+		Expr *node = top->expr;
+		bool done = true;
+
+		switch (node->type)
+		{
+			case EXPR_NUMBER:
+			{
+				Emit(&compiler, OPC_PUSH, AddConstant(&compiler, node->as.number), +1);
+			} break;
+
+			case EXPR_VARIABLE:
+			{
+				UseVariable(&compiler, node->as.variable.slot);
+				Emit(&compiler, OPC_LOAD, node->as.variable.slot, +1);
+			} break;
+
+			case EXPR_BINOP:
+			{
+				BinNode *bn = &node->as.binop;
+				int halves;
+
+				if (bn->op == OP_ASSIGN)
+				{
+					if (top->visits++ == 0)
+					{
+						next = bn->rhs;
+						done = false;
+						break;
+					}
+					UseVariable(&compiler, bn->lhs->as.variable.slot);
+					Emit(&compiler, OPC_STORE, bn->lhs->as.variable.slot, 0);
+					break;
+				}
+
+				switch (top->visits++)
+				{
+					case 0:
+						next = bn->lhs;
+						done = false;
+						break;
+
+					case 1:
+						// Small constant powers are multiplications and a sqrt, not pow.
+						if (bn->op == OP_EXP && ExprConstantHalves(bn->rhs, &halves))
+						{
+							if (halves == 1) Emit(&compiler, OPC_SQRT, 0, 0);
+							else Emit(&compiler, OPC_POWN, halves, 0);
+							break;
+						}
+						next = bn->rhs;
+						done = false;
+						break;
+
+					default:
+						Emit(&compiler, BinaryOpcode(bn->op), 0, -1);
+						break;
+				}
+			} break;
+
+			default:
+				assert(0 && "Invalid code path!");
+				break;
+		}
+
+		if (!done) continue;
+
+		if (node->flags & EXPR_FLAG_NEGATED)
+		{
+			Emit(&compiler, OPC_NEG, 0, 0);
+		}
+		--depth;
+	}
+
+	free(stack);
+
+	if (compiler.error)
+	{
+		ProgramFree(&compiler.program);
+		compiler.program.error = compiler.error;
+	}
+
+	return compiler.program;
+}
+
+double RunProgram(const Program *program, double *variables)
+{
+	double localStack[64];
+	double *stack = localStack;
+
+	if (program->maxStackDepth > (int)(sizeof(localStack)/sizeof(*localStack)))
+	{
+		stack = malloc(program->maxStackDepth * sizeof(*stack));
+		assert(stack && "Out of memory");
+	}
+
+	const Instruction *ip = program->code;
+	const Instruction *end = ip + program->codeLen;
+	const double *constants = program->constants;
+
+	// sp points at the top of the stack, one below the first free slot.
+	double *sp = stack - 1;
+
+	while (ip < end)
+	{
+		Instruction instruction = *ip++;
+
+		switch (INSTRUCTION_OPCODE(instruction))
+		{
+			case OPC_PUSH: *++sp = constants[INSTRUCTION_OPERAND(instruction)]; break;
+			case OPC_ADD: sp[-1] = sp[-1] + sp[0]; --sp; break;
+			case OPC_SUB: sp[-1] = sp[-1] - sp[0]; --sp; break;
+			case OPC_MUL: sp[-1] = sp[-1] * sp[0]; --sp; break;
+			case OPC_DIV: sp[-1] = sp[-1] / sp[0]; --sp; break;
+			case OPC_POW: sp[-1] = pow(sp[-1], sp[0]); --sp; break;
+			case OPC_NEG: sp[0] = -sp[0]; break;
+			case OPC_LOAD: *++sp = variables[INSTRUCTION_OPERAND(instruction)]; break;
+			case OPC_STORE: variables[INSTRUCTION_OPERAND(instruction)] = sp[0]; break;
+			case OPC_SQRT: sp[0] = sqrt(sp[0]); break;
+			case OPC_POWN: sp[0] = PowHalves(sp[0], INSTRUCTION_SIGNED_OPERAND(instruction)); break;
+		}
+	}
+
+	assert(sp == stack);
+	double result = *sp;
+
+	if (stack != localStack) free(stack);
+
+	return result;
+}
+
+void ProgramFree(Program *program)
+{
+	free(program->code);
+	free(program->constants);
+	*program = (Program){0};
+}
\ No newline at end of file
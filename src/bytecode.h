@@ -0,0 +1,63 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include <stdint.h>
+
+#include "parser.h"
+
+typedef enum
+{
+	OPC_PUSH, // Push constants[operand]
+	OPC_ADD,
+	OPC_SUB,
+	OPC_MUL,
+	OPC_DIV,
+	OPC_POW,
+	OPC_NEG,
+	OPC_LOAD,  // Push variables[operand]
+	OPC_STORE, // variables[operand] = top of the stack, which stays pushed
+	OPC_SQRT,
+	OPC_POWN,  // Top of the stack to the power of operand/2, see PowHalves
+} Opcode;
+
+// An instruction is the opcode in the low byte and the operand in the
+// remaining 24 bits.
+typedef uint32_t Instruction;
+
+#define INSTRUCTION(opcode, operand) ((Instruction)(opcode) | ((Instruction)(operand) << 8))
+#define INSTRUCTION_OPCODE(instruction) ((Opcode)((instruction) & 0xff))
+#define INSTRUCTION_OPERAND(instruction) ((int)((instruction) >> 8))
+#define INSTRUCTION_SIGNED_OPERAND(instruction) ((int)((int32_t)(instruction) >> 8))
+
+// Constants and variable slots a program can address.
+#define PROGRAM_OPERAND_LIMIT (1 << 24)
+
+typedef struct Program_t
+{
+	Instruction *code;
+	int codeLen;
+	int codeCapacity;
+
+	double *constants;
+	int constantCount;
+	int constantCapacity;
+
+	int maxStackDepth;
+	int variableCount; // One more than the highest slot loaded or stored
+
+	const char *error; // Why the expression could not be compiled, or NULL
+} Program;
+
+// Lowers the expression tree to a flat sequence of stack machine
+// instructions in post order. Expressions with more distinct constants or
+// variables than PROGRAM_OPERAND_LIMIT are not compiled; the program is
+// then empty but for its error.
+Program CompileExpr(Expr *expr);
+
+// variables holds the value of each slot of the scope the expression was
+// parsed in, as for EvalExpr.
+double RunProgram(const Program *program, double *variables);
+
+void ProgramFree(Program *program);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,132 @@
+#include "calc.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tokenizer.h"
+#include "parser.h"
+#include "bytecode.h"
+#include "columns.h"
+#include "jit.h"
+#include "optimize.h"
+
+struct CalcExpr_t
+{
+	Program program;
+	JitCode jit;       // No fn where there is no JIT
+	Scope scope;       // Only the names; the tree is gone after compiling
+	double *variables; // Bound values, scope.count of them
+};
+
+static void SetError(CalcError *error, const char *message, int line, int column)
+{
+	if (!error) return;
+
+	snprintf(error->message, sizeof(error->message), "%s", message);
+	error->line = line;
+	error->column = column;
+}
+
+CalcExpr *CalcCompile(const char *source, size_t len, CalcError *error)
+{
+	if (len > TOKEN_STREAM_MAX_BYTES)
+	{
+		SetError(error, "Expression too long", 0, 0);
+		return NULL;
+	}
+
+	TokenStream ts = TokenStreamFromBuffer(source, len);
+
+	Parser parser;
+	ParserInit(&parser, &ts);
+	Expr *tree = ParseExpression(&parser, 0, (Token){TOK_INPUT_END});
+
+	if (!tree || tree->type == EXPR_PARSE_ERROR)
+	{
+		if (tree) SetError(error, tree->as.error.message, tree->as.error.line, tree->as.error.column);
+		else SetError(error, "Empty expression", 0, 0);
+
+		ParserRelease(&parser);
+		return NULL;
+	}
+
+	tree = OptimizeExpr(tree);
+	Program program = CompileExpr(tree);
+
+	if (program.error)
+	{
+		SetError(error, program.error, 0, 0);
+		ParserRelease(&parser);
+		return NULL;
+	}
+
+	CalcExpr *expr = calloc(1, sizeof(*expr));
+	assert(expr && "Out of memory");
+
+	expr->program = program;
+	JitCompile(tree, &expr->jit);
+
+	// Callers may evaluate columns on several threads at once.
+	ColumnsPrepare();
+
+	// Keep the names, let the parser free the tree and the tokens.
+	expr->scope = parser.scope;
+	parser.scope = (Scope){0};
+	ParserRelease(&parser);
+
+	expr->variables = calloc(expr->scope.count ? expr->scope.count : 1, sizeof(*expr->variables));
+	assert(expr->variables && "Out of memory");
+
+	return expr;
+}
+
+int CalcVariableCount(const CalcExpr *expr)
+{
+	return expr->scope.count;
+}
+
+const char *CalcVariableName(const CalcExpr *expr, int slot)
+{
+	assert(slot >= 0 && slot < expr->scope.count);
+	return expr->scope.names[slot].chars;
+}
+
+int CalcVariableSlot(const CalcExpr *expr, const char *name)
+{
+	return ScopeFind(&expr->scope, name, strlen(name));
+}
+
+void CalcBind(CalcExpr *expr, int slot, double value)
+{
+	assert(slot >= 0 && slot < expr->scope.count);
+	expr->variables[slot] = value;
+}
+
+double CalcEvaluate(CalcExpr *expr)
+{
+	return CalcEvaluateWith(expr, expr->variables);
+}
+
+double CalcEvaluateWith(const CalcExpr *expr, double *variables)
+{
+	if (expr->jit.fn) return expr->jit.fn(variables);
+	return RunProgram(&expr->program, variables);
+}
+
+void CalcEvaluateColumns(const CalcExpr *expr, const double *const *columns, double *results, size_t rowCount)
+{
+	RunProgramColumns(&expr->program, columns, results, rowCount);
+}
+
+void CalcRelease(CalcExpr *expr)
+{
+	if (!expr) return;
+
+	ProgramFree(&expr->program);
+	JitFree(&expr->jit);
+	ScopeFree(&expr->scope);
+	free(expr->variables);
+	free(expr);
+}
\ No newline at end of file
@@ -0,0 +1,56 @@
+#ifndef CALC_H
+#define CALC_H
+
+#include <stddef.h>
+
+// Embedding API: compile an expression once, then bind its variables and
+// evaluate it as often as needed. Link with build/libcalc.a (./nob lib).
+
+typedef struct CalcExpr_t CalcExpr;
+
+typedef struct CalcError_t
+{
+	char message[128];
+	int line;   // Zero based
+	int column; // Zero based
+} CalcError;
+
+// Parses, simplifies (see optimize.h) and compiles the len characters of
+// source, which need not be null terminated and are not referenced
+// afterwards. Returns NULL and fills in error, if given, when the source
+// does not parse, holds no expression, is too long for 32-bit token
+// offsets (4 GiB) or has more constants or variables than the VM can
+// address (2^24).
+CalcExpr *CalcCompile(const char *source, size_t len, CalcError *error);
+
+// Variables are numbered 0..CalcVariableCount-1 in order of first
+// appearance in the source.
+int CalcVariableCount(const CalcExpr *expr);
+const char *CalcVariableName(const CalcExpr *expr, int slot);
+
+// Returns the slot of the named variable, or -1 if the source has none.
+int CalcVariableSlot(const CalcExpr *expr, const char *name);
+
+// Sets the value the variable has at the start of the next CalcEvaluate.
+// Every variable starts out as 0.
+void CalcBind(CalcExpr *expr, int slot, double value);
+
+// Evaluates with the bound values. Assignments in the expression overwrite
+// them, as if bound with CalcBind.
+double CalcEvaluate(CalcExpr *expr);
+
+// Evaluates with the caller's values, CalcVariableCount of them, indexed by
+// slot. Does not touch the handle, so threads may share one CalcExpr as
+// long as each passes its own variables.
+double CalcEvaluateWith(const CalcExpr *expr, double *variables);
+
+// Evaluates once per row, into results[row], for rowCount rows of
+// structure-of-arrays input: columns[slot] holds the rowCount values of
+// variable slot, or is NULL for a variable that is 0 in every row. Runs each
+// operator over a block of rows at a time with SIMD; see columns.h. Does not
+// touch the handle.
+void CalcEvaluateColumns(const CalcExpr *expr, const double *const *columns, double *results, size_t rowCount);
+
+void CalcRelease(CalcExpr *expr);
+
+#endif
\ No newline at end of file
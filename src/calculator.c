@@ -7,14 +7,45 @@
 
 #include "tokenizer.h"
 #include "parser.h"
+#include "ast.h"
+#include "bytecode.h"
+#include "jit.h"
+#include "optimize.h"
+#include "input.h"
+#include "columns.h"
+#include "table.h"
+#include "pool.h"
+#include "pipeline.h"
+#include "parlex.h"
+#include "cpu.h"
 
 #define CL_OPTION_LIST(X) \
-	X("-print-infix" ,                , PRINT_INFIX  , "Print parenthesized expression with infix operators.") \
-	X("-print-s"     ,                , PRINT_S      , "Print parenthesized s-expression.") \
-	X("-print-rpn"   ,                , PRINT_RPN    , "Print expression in reverse polish notation (RPN).") \
-	X("-input="      , "<expression>" , INPUT_DIRECT , "Directly passed input") \
+	X("-print-infix"  ,                    , PRINT_INFIX , "Print parenthesized expression with infix operators.") \
+	X("-print-s"      ,                    , PRINT_S     , "Print parenthesized s-expression.") \
+	X("-print-rpn"    ,                    , PRINT_RPN   , "Print expression in reverse polish notation (RPN).") \
+	X("-input="       , "<expression>"     , INPUT_DIRECT, "Directly passed input") \
+	X("-engine="      , "<tree|ast|vm|jit>", ENGINE      , "Evaluate by walking the tree (default), over a compact copy of it, with the bytecode VM or as machine code.") \
+	X("-optimize"     ,                    , OPTIMIZE    , "Simplify the expression before evaluating it, and report the node counts.") \
+	X("-batch"        ,                    , BATCH       , "Evaluate each line of the input as a separate expression.") \
+	X("-table="       , "<file>"           , TABLE       , "Evaluate the expression once per row of a CSV table of variable values.") \
+	X("-table-binary=", "<file>"           , TABLE_BINARY, "Like -table, for a header line followed by rows of native doubles.") \
+	X("-threads="     , "<count>"          , THREADS     , "Threads evaluating a table or lexing a large input. Defaults to one per processor.") \
+	X("-pipeline"     ,                    , PIPELINE    , "Lex a single expression on a second thread while parsing it, and report the counters. Ignored with -batch.") \
 	//END
 
+#define ENGINE_LIST(X) \
+	X("tree", TREE) \
+	X("ast" , AST ) \
+	X("vm"  , VM  ) \
+	X("jit" , JIT ) \
+	//END
+
+#define ENGINE_ENUM(engineStr, engineNum) ENGINE_##engineNum,
+typedef enum
+{
+	ENGINE_LIST(ENGINE_ENUM)
+} Engine;
+
 #define CL_OPTION_ENUM_BIT_NUM(optionStr, arg0, optionNum, description) CL_OPTION_BIT_NUM_##optionNum,
 enum ClOptionBitIndex
 {
@@ -32,6 +63,9 @@ typedef struct Options_t
 {
 	const char *program;
 	enum OptionFlags flags;
+	Engine engine;
+	const char *tablePath;
+	int threadCount;
 
 	union
 	{
@@ -43,7 +77,7 @@ typedef struct Options_t
 
 static void ExitPrintUsage(const char *program, int exitCode)
 {
-#define CL_OPTION_PRINT_FORMAT(optionStr, arg0, optionNum, description) "  %-24s %s\n"
+#define CL_OPTION_PRINT_FORMAT(optionStr, arg0, optionNum, description) "  %-26s %s\n"
 #define CL_OPTION_PRINT_ARGS(optionStr, arg0, optionNum, description) ,optionStr arg0, description
 
 	fprintf(stderr,
@@ -97,6 +131,29 @@ Options ParseCommandLineOptions(int argc, char const **argv)
 			options.input.direct = argRest;
 			needsMoreArguments = false;
 		}
+		else if (flag == CL_OPTION_TABLE || flag == CL_OPTION_TABLE_BINARY)
+		{
+			options.tablePath = argRest;
+		}
+		else if (flag == CL_OPTION_THREADS)
+		{
+			options.threadCount = atoi(argRest);
+			if (options.threadCount < 1)
+			{
+				fprintf(stderr, "[ERROR] Thread count must be at least 1, '%.256s'.\n", argRest);
+				ExitPrintUsage(options.program, 1);
+			}
+		}
+		else if (flag == CL_OPTION_ENGINE)
+		{
+#define ENGINE_STRCMP(engineStr, engineNum) \
+			if (strcmp((engineStr), argRest) == 0) options.engine = ENGINE_##engineNum; else
+			ENGINE_LIST(ENGINE_STRCMP)
+			{
+				fprintf(stderr, "[ERROR] Unknown engine, '%.256s'.\n", argRest);
+				ExitPrintUsage(options.program, 1);
+			}
+		}
 
 		--argc;
 		++argv;
@@ -128,89 +185,125 @@ Options ParseCommandLineOptions(int argc, char const **argv)
 	return options;
 }
 
-int ReadEntireFile(FILE *file, char **contents, size_t *contentsLen)
-{
-	*contents = NULL;
-	if (!file) return -1;
-	if (fseek(file, 0, SEEK_END) < 0) goto error;
-#ifndef _WIN32
-    *contentsLen = ftell(file);
-#else
-    *contentsLen = _ftelli64(file);
-#endif
-    if (*contentsLen < 0) goto error;
-    if (fseek(file, 0, SEEK_SET) < 0) goto error;
-
-	*contents = malloc(*contentsLen + 1);
-	if (1 != fread(*contents, *contentsLen, 1, file))
-	{
-		perror("Could not read file");
-		goto error;
-	}
-
-	(*contents)[*contentsLen] = '\0';
-	return 0;
-error:
-	fprintf(stderr, "[ERROR] Could not read file: %s\n", strerror(errno));
-	if (file != stdin) fclose(file);
-	if (*contents) free(*contents);
-	return -1;
-}
-
-int main(int argc, char const *argv[])
+// Values of the variables, indexed by the slots of the parser's scope. They
+// live as long as the parser, so batch lines can use earlier assignments.
+typedef struct Variables_t
 {
-	Options options = ParseCommandLineOptions(argc, argv);
-
-	const char *input;
+	double *values;
+	int count;
+} Variables;
 
-	if (options.flags & CL_OPTION_INPUT_DIRECT)
+// Makes room for every slot the scope has handed out. New variables are 0.
+static double *VariablesFor(Variables *variables, const Scope *scope)
+{
+	if (variables->count < scope->count)
 	{
-		input = options.input.direct;
+		variables->values = realloc(variables->values, scope->count * sizeof(*variables->values));
+		assert(variables->values && "Out of memory");
+
+		for (int slot = variables->count; slot < scope->count; ++slot) variables->values[slot] = 0;
+		variables->count = scope->count;
 	}
-	else
+
+	return variables->values;
+}
+
+static double Evaluate(Engine engine, Expr *expr, double *variables)
+{
+	switch (engine)
 	{
-		size_t inputContentsLen;
-		if (ReadEntireFile(options.input.file, (char **)&input, &inputContentsLen) == -1)
+		case ENGINE_JIT:
 		{
-			return -1;
+			JitCode code;
+			if (JitCompile(expr, &code))
+			{
+				double result = code.fn(variables);
+				JitFree(&code);
+				return result;
+			}
+		} // Fall back to the VM where there is no JIT
+		// fallthrough
+
+		case ENGINE_VM:
+		{
+			Program program = CompileExpr(expr);
+			if (program.error)
+			{
+				fprintf(stderr, "[WARNING] %s; walking the tree instead.\n", program.error);
+				return EvalExpr(expr, variables);
+			}
+
+			double result = RunProgram(&program, variables);
+			ProgramFree(&program);
+			return result;
 		}
+
+		case ENGINE_TREE:
+		default:
+			return EvalExpr(expr, variables);
 	}
+}
 
-	TokenStream ts = TokenStreamFromCStr(input);
+// Reports the node counts on stderr, where they stay out of the results.
+static Expr *Optimize(Expr *expr)
+{
+	int before = CountExprNodes(expr);
+	expr = OptimizeExpr(expr);
+	fprintf(stderr, "Optimized: %d nodes -> %d nodes\n", before, CountExprNodes(expr));
+	return expr;
+}
 
-	Expr *parsedExpression = ParseExpression(&ts, 0, (Token){TOK_INPUT_END});
+// Parses and evaluates one expression and prints the result. lineNumber is
+// added to the line of any parse error. Returns false on a parse error.
+static bool RunExpression(const Options *options, Parser *parser, Variables *variables, int lineNumber)
+{
+	Expr *parsedExpression = ParseExpression(parser, 0, (Token){TOK_INPUT_END});
 
 	if (parsedExpression && parsedExpression->type == EXPR_PARSE_ERROR)
 	{
 		ParseError err = parsedExpression->as.error;
-		fprintf(stderr, "Error parsing [location:%d:%d]: (%s)\n", err.line, err.column, err.message);
-		return 1;
+		fprintf(stderr, "Error parsing [location:%d:%d]: (%s)\n", lineNumber + err.line, err.column, err.message);
+		return false;
 	}
 
-	if (options.flags & CL_OPTION_PRINT_INFIX)
+	if (parsedExpression && (options->flags & CL_OPTION_OPTIMIZE))
+	{
+		parsedExpression = Optimize(parsedExpression);
+	}
+
+	// The ast engine prints from the compact copy as well.
+	Ast ast = {0};
+	bool useAst = parsedExpression && options->engine == ENGINE_AST;
+	if (useAst) AstFromExpr(&ast, parsedExpression);
+
+	if (options->flags & CL_OPTION_PRINT_INFIX)
 	{
 		printf("Interpretation (Infix): ");
-		PrintExprInfix(parsedExpression);
+		if (useAst) PrintAstInfix(&ast);
+		else PrintExprInfix(parsedExpression);
 		printf("\n");
 	}
 
-	if (options.flags & CL_OPTION_PRINT_S)
+	if (options->flags & CL_OPTION_PRINT_S)
 	{
 		printf("Interpretation (S-expression): ");
-		PrintExprS(parsedExpression);
+		if (useAst) PrintAstS(&ast);
+		else PrintExprS(parsedExpression);
 		printf("\n");
 	}
 
-	if (options.flags & CL_OPTION_PRINT_RPN)
+	if (options->flags & CL_OPTION_PRINT_RPN)
 	{
 		printf("Interpretation (RPN): ");
-		PrintExprRpn(parsedExpression);
+		if (useAst) PrintAstRpn(&ast);
+		else PrintExprRpn(parsedExpression);
 		printf("\n");
 	}
 
 	if (parsedExpression)
 	{
-		double result = EvalExpr(parsedExpression);
+		double *values = VariablesFor(variables, &parser->scope);
+		double result = useAst ? EvalAst(&ast, values) : Evaluate(options->engine, parsedExpression, values);
 		printf("%g\n", result);
 	}
 	else
@@ -218,5 +311,344 @@ int main(int argc, char const *argv[])
 		printf("()\n");
 	}
 
-	return 0;
+	AstFree(&ast);
+	return true;
 }
+
+// Evaluates every line of the input on its own, printing one result per
+// line as soon as the line has been read. A line that does not parse prints
+// "error". The parser's memory is reused from one line to the next.
+static bool RunBatch(const Options *options, LineReader *reader)
+{
+	static char outputBuffer[1 << 16];
+	setvbuf(stdout, outputBuffer, _IOFBF, sizeof(outputBuffer));
+
+	// Hand over the results so far whenever we have to wait for input.
+	reader->flushBeforeRead = stdout;
+
+	Parser parser = {0};
+	Variables variables = {0};
+	bool allParsed = true;
+
+	const char *line;
+	size_t lineLen;
+
+	for (int lineNumber = 0; ReadLine(reader, &line, &lineLen); ++lineNumber)
+	{
+		if (lineLen > TOKEN_STREAM_MAX_BYTES)
+		{
+			fprintf(stderr, "Error parsing [location:%d:0]: (Line too long; expressions are limited to %zu bytes)\n", lineNumber, TOKEN_STREAM_MAX_BYTES);
+			printf("error\n");
+			allParsed = false;
+			continue;
+		}
+
+		// Lines of an input already in memory stay valid to the end; lines read
+		// from a file are overwritten by later ones, so their names are copied.
+		TokenStream ts = TokenStreamFromBuffer(line, lineLen);
+		ts.identViews = reader->capacity == 0;
+		ParserReset(&parser, &ts);
+
+		if (!RunExpression(options, &parser, &variables, lineNumber))
+		{
+			printf("error\n");
+			allParsed = false;
+		}
+	}
+
+	ParserRelease(&parser);
+	free(variables.values);
+	fflush(stdout);
+
+	return allParsed && !reader->failed;
+}
+
+// Rows evaluated by one task of the thread pool.
+#define TABLE_CHUNK_ROWS (64*1024)
+
+// Chunks evaluated before their results are written, per thread.
+#define TABLE_CHUNKS_PER_THREAD 4
+
+typedef struct TableJob_t
+{
+	const Program *program;
+	const double **columns; // Indexed by slot
+	double *results;
+	size_t rowCount;
+
+	size_t firstChunk; // Of the current wave
+	char **texts;      // Formatted results of each chunk of the wave
+	size_t *textLens;
+} TableJob;
+
+static void EvaluateTableChunk(void *context, size_t task)
+{
+	TableJob *job = context;
+
+	size_t start = (job->firstChunk + task) * TABLE_CHUNK_ROWS;
+	size_t count = job->rowCount - start;
+	if (count > TABLE_CHUNK_ROWS) count = TABLE_CHUNK_ROWS;
+
+	int variableCount = job->program->variableCount;
+	const double **columns = malloc((variableCount ? variableCount : 1) * sizeof(*columns));
+	assert(columns && "Out of memory");
+
+	for (int slot = 0; slot < variableCount; ++slot)
+	{
+		columns[slot] = job->columns[slot] ? job->columns[slot] + start : NULL;
+	}
+
+	double *results = job->results + start;
+	RunProgramColumns(job->program, columns, results, count);
+	free(columns);
+
+	// Formatting costs more than evaluating, so it is done here too.
+	char *text = job->texts[task];
+	size_t len = 0;
+	for (size_t row = 0; row < count; ++row)
+	{
+		len += sprintf(text + len, "%g\n", results[row]);
+	}
+	job->textLens[task] = len;
+}
+
+static bool LoadTable(const Options *options, Table *table)
+{
+	FILE *file = fopen(options->tablePath, "rb");
+	if (!file)
+	{
+		fprintf(stderr, "[ERROR] Could not open file, '%.256s'.\n", options->tablePath);
+		return false;
+	}
+
+	MappedFile mapped;
+	char *contents = NULL;
+	const char *data;
+	size_t len;
+
+	if (MapFile(file, &mapped))
+	{
+		data = mapped.data;
+		len = mapped.len;
+	}
+	else
+	{
+		if (ReadEntireFile(file, &contents, &len) == -1) return false;
+		data = contents;
+	}
+
+	bool loaded = (options->flags & CL_OPTION_TABLE_BINARY)
+		? TableFromBinary(data, len, table)
+		: TableFromCsv(data, len, table);
+
+	UnmapFile(&mapped);
+	free(contents);
+	fclose(file);
+	return loaded;
+}
+
+// Evaluates the expression once per row of the table, binding variables to
+// the columns of the same name, and prints the results in row order. The
+// rows are split into chunks spread over a thread pool, a wave of chunks at
+// a time so only a wave's worth of output is held in memory.
+static bool RunTable(const Options *options, Parser *parser)
+{
+	Expr *expr = ParseExpression(parser, 0, (Token){TOK_INPUT_END});
+	if (!expr || expr->type == EXPR_PARSE_ERROR)
+	{
+		if (expr) fprintf(stderr, "Error parsing [location:%d:%d]: (%s)\n", expr->as.error.line, expr->as.error.column, expr->as.error.message);
+		else fprintf(stderr, "[ERROR] No expression to evaluate.\n");
+		return false;
+	}
+
+	if (options->flags & CL_OPTION_OPTIMIZE) expr = Optimize(expr);
+
+	Table table;
+	if (!LoadTable(options, &table)) return false;
+
+	Program program = CompileExpr(expr);
+	if (program.error)
+	{
+		fprintf(stderr, "[ERROR] %s.\n", program.error);
+		TableFree(&table);
+		return false;
+	}
+
+	const double **columns = malloc((program.variableCount ? program.variableCount : 1) * sizeof(*columns));
+	assert(columns && "Out of memory");
+
+	for (int slot = 0; slot < program.variableCount; ++slot)
+	{
+		Ident name = parser->scope.names[slot];
+		int column = TableFindColumn(&table, name.chars, name.len);
+		if (column < 0) fprintf(stderr, "[WARNING] Variable '%.*s' is not a table column; it starts out as 0.\n", (int)name.len, name.chars);
+		columns[slot] = column < 0 ? NULL : TableColumn(&table, column);
+	}
+
+	int threadCount = options->threadCount ? options->threadCount : CpuCount();
+	ThreadPool pool;
+	if (!PoolInit(&pool, threadCount))
+	{
+		fprintf(stderr, "[WARNING] Could not start %d threads; evaluating on one.\n", threadCount);
+		PoolInit(&pool, 1);
+	}
+
+	size_t chunkCount = (table.rowCount + TABLE_CHUNK_ROWS - 1) / TABLE_CHUNK_ROWS;
+	size_t waveChunks = (size_t)(pool.threadCount + 1) * TABLE_CHUNKS_PER_THREAD;
+	if (waveChunks > chunkCount) waveChunks = chunkCount;
+
+	TableJob job = {
+		.program = &program,
+		.columns = columns,
+		.results = malloc((table.rowCount ? table.rowCount : 1) * sizeof(*job.results)),
+		.rowCount = table.rowCount,
+		.texts = calloc(waveChunks ? waveChunks : 1, sizeof(*job.texts)),
+		.textLens = calloc(waveChunks ? waveChunks : 1, sizeof(*job.textLens)),
+	};
+	assert(job.results && job.texts && job.textLens && "Out of memory");
+
+	// %g never takes more than 13 characters, plus the newline.
+	for (size_t i = 0; i < waveChunks; ++i)
+	{
+		job.texts[i] = malloc(TABLE_CHUNK_ROWS * 16);
+		assert(job.texts[i] && "Out of memory");
+	}
+
+	// The workers would otherwise race to pick the kernel on their first run.
+	ColumnsPrepare();
+
+	for (; job.firstChunk < chunkCount; job.firstChunk += waveChunks)
+	{
+		size_t taskCount = chunkCount - job.firstChunk;
+		if (taskCount > waveChunks) taskCount = waveChunks;
+
+		PoolRun(&pool, taskCount, EvaluateTableChunk, &job);
+
+		for (size_t task = 0; task < taskCount; ++task)
+		{
+			fwrite(job.texts[task], 1, job.textLens[task], stdout);
+		}
+	}
+
+	fflush(stdout);
+
+	for (size_t i = 0; i < waveChunks; ++i) free(job.texts[i]);
+	free(job.texts);
+	free(job.textLens);
+	free(job.results);
+	PoolRelease(&pool);
+	free(columns);
+	ProgramFree(&program);
+	TableFree(&table);
+	return true;
+}
+
+int main(int argc, char const *argv[])
+{
+	Options options = ParseCommandLineOptions(argc, argv);
+
+	// Regular files are tokenized straight out of a read-only mapping.
+	MappedFile mapped = {0};
+	bool isMapped = !(options.flags & CL_OPTION_INPUT_DIRECT) && MapFile(options.input.file, &mapped);
+
+	if (options.flags & CL_OPTION_BATCH)
+	{
+		if (options.flags & CL_OPTION_PIPELINE)
+		{
+			fprintf(stderr, "[WARNING] -pipeline only applies to a single expression; ignored with -batch.\n");
+		}
+
+		LineReader reader;
+		if (options.flags & CL_OPTION_INPUT_DIRECT) reader = LineReaderFromBuffer(options.input.direct, strlen(options.input.direct));
+		else if (isMapped) reader = LineReaderFromBuffer(mapped.data, mapped.len);
+		else reader = LineReaderFromFile(options.input.file);
+
+		bool succeeded = RunBatch(&options, &reader);
+
+		LineReaderFree(&reader);
+		UnmapFile(&mapped);
+		return succeeded ? 0 : 1;
+	}
+
+	const char *input;
+	size_t inputContentsLen;
+	char *inputContents = NULL;
+
+	if (options.flags & CL_OPTION_INPUT_DIRECT)
+	{
+		input = options.input.direct;
+		inputContentsLen = strlen(input);
+	}
+	else if (isMapped)
+	{
+		input = mapped.data;
+		inputContentsLen = mapped.len;
+	}
+	else
+	{
+		if (ReadEntireFile(options.input.file, &inputContents, &inputContentsLen) == -1)
+		{
+			return -1;
+		}
+		input = inputContents;
+	}
+
+	if (inputContentsLen > TOKEN_STREAM_MAX_BYTES)
+	{
+		fprintf(stderr, "[ERROR] Input of %zu bytes is too large; expressions are limited to %zu bytes.\n", inputContentsLen, TOKEN_STREAM_MAX_BYTES);
+		UnmapFile(&mapped);
+		free(inputContents);
+		return 1;
+	}
+
+	// The input outlives the parser, so names can point into it.
+	TokenStream ts = TokenStreamFromBuffer(input, inputContentsLen);
+	ts.identViews = true;
+
+	Parser parser = {0};
+	Pipeline pipeline;
+	bool pipelined = (options.flags & CL_OPTION_PIPELINE) && PipelineStart(&pipeline, &parser, &ts);
+
+	if ((options.flags & CL_OPTION_PIPELINE) && !pipelined)
+	{
+		fprintf(stderr, "[WARNING] Could not start the lexer thread; lexing before parsing.\n");
+	}
+
+	if (!pipelined)
+	{
+		// Large inputs are lexed on a thread pool, which is done with once
+		// the tokens are in.
+		int threadCount = options.threadCount ? options.threadCount : CpuCount();
+		ThreadPool pool;
+
+		if (threadCount > 1 && inputContentsLen >= PARLEX_MIN_INPUT_BYTES && PoolInit(&pool, threadCount))
+		{
+			ParserInitParallel(&parser, &ts, &pool);
+			PoolRelease(&pool);
+		}
+		else
+		{
+			ParserInit(&parser, &ts);
+		}
+	}
+
+	Variables variables = {0};
+	bool parsed = options.tablePath
+		? RunTable(&options, &parser)
+		: RunExpression(&options, &parser, &variables, 0);
+
+	if (pipelined)
+	{
+		PipelineStats stats;
+		PipelineFinish(&pipeline, &stats);
+		fprintf(stderr, "Pipeline: %zu tokens in %zu batches, lexed in %.3f s; lexer waited %zu times, parser %zu times for %.3f s\n",
+			stats.tokens, stats.batches, stats.lexSeconds, stats.lexerWaits, stats.parserWaits, stats.waitSeconds);
+	}
+
+	ParserRelease(&parser);
+	free(variables.values);
+	UnmapFile(&mapped);
+	free(inputContents);
+
+	return parsed ? 0 : 1;
+}
\ No newline at end of file
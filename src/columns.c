@@ -0,0 +1,327 @@
+#include "columns.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cpu.h"
+
+#if CPU_X86
+#include <emmintrin.h>
+#include <immintrin.h>
+#endif
+
+// Rows evaluated together. A multiple of every vector width, and small
+// enough that the stack of blocks of a typical program stays in L1.
+#define BLOCK_ROWS 256
+
+// lhs[i] = lhs[i] op rhs[i] for a binary opcode, lhs[i] = op lhs[i] for a
+// unary one, in which case rhs is not read.
+typedef void ApplyFn(Opcode opcode, double *lhs, const double *rhs, size_t count);
+
+static ApplyFn ApplyResolve;
+
+static bool IsUnary(Opcode opcode)
+{
+	return opcode == OPC_NEG || opcode == OPC_SQRT;
+}
+
+static ApplyFn *applyKernel = ApplyResolve;
+
+//
+// Scalar
+//
+
+static void ApplyScalar(Opcode opcode, double *lhs, const double *rhs, size_t count)
+{
+	switch (opcode)
+	{
+		case OPC_ADD: for (size_t i = 0; i < count; ++i) lhs[i] = lhs[i] + rhs[i]; break;
+		case OPC_SUB: for (size_t i = 0; i < count; ++i) lhs[i] = lhs[i] - rhs[i]; break;
+		case OPC_MUL: for (size_t i = 0; i < count; ++i) lhs[i] = lhs[i] * rhs[i]; break;
+		case OPC_DIV: for (size_t i = 0; i < count; ++i) lhs[i] = lhs[i] / rhs[i]; break;
+		case OPC_POW: for (size_t i = 0; i < count; ++i) lhs[i] = pow(lhs[i], rhs[i]); break;
+		case OPC_NEG: for (size_t i = 0; i < count; ++i) lhs[i] = -lhs[i]; break;
+		case OPC_SQRT: for (size_t i = 0; i < count; ++i) lhs[i] = sqrt(lhs[i]); break;
+		default:
+			assert(0 && "Invalid code path!");
+	}
+}
+
+#if CPU_X86
+
+//
+// SSE2
+//
+
+// There is no vector pow; the scalar loop finishes whatever the vector loop
+// did not do, all of it in the case of pow.
+static void ApplySse2(Opcode opcode, double *lhs, const double *rhs, size_t count)
+{
+	size_t i = 0;
+
+	switch (opcode)
+	{
+#define APPLY_SSE2(OPCODE, intrinsic) \
+		case OPCODE: \
+			for (; i + 2 <= count; i += 2) \
+			{ \
+				_mm_storeu_pd(lhs + i, intrinsic(_mm_loadu_pd(lhs + i), _mm_loadu_pd(rhs + i))); \
+			} \
+			break;
+
+		APPLY_SSE2(OPC_ADD, _mm_add_pd)
+		APPLY_SSE2(OPC_SUB, _mm_sub_pd)
+		APPLY_SSE2(OPC_MUL, _mm_mul_pd)
+		APPLY_SSE2(OPC_DIV, _mm_div_pd)
+#undef APPLY_SSE2
+
+		case OPC_NEG:
+		{
+			const __m128d sign = _mm_set1_pd(-0.0);
+			for (; i + 2 <= count; i += 2)
+			{
+				_mm_storeu_pd(lhs + i, _mm_xor_pd(_mm_loadu_pd(lhs + i), sign));
+			}
+		} break;
+
+		case OPC_SQRT:
+		{
+			for (; i + 2 <= count; i += 2)
+			{
+				_mm_storeu_pd(lhs + i, _mm_sqrt_pd(_mm_loadu_pd(lhs + i)));
+			}
+		} break;
+
+		default:
+			break;
+	}
+
+	if (i < count) ApplyScalar(opcode, lhs + i, IsUnary(opcode) ? NULL : rhs + i, count - i);
+}
+
+//
+// AVX2
+//
+
+TARGET_AVX2
+static void ApplyAvx2(Opcode opcode, double *lhs, const double *rhs, size_t count)
+{
+	size_t i = 0;
+
+	switch (opcode)
+	{
+#define APPLY_AVX2(OPCODE, intrinsic) \
+		case OPCODE: \
+			for (; i + 4 <= count; i += 4) \
+			{ \
+				_mm256_storeu_pd(lhs + i, intrinsic(_mm256_loadu_pd(lhs + i), _mm256_loadu_pd(rhs + i))); \
+			} \
+			break;
+
+		APPLY_AVX2(OPC_ADD, _mm256_add_pd)
+		APPLY_AVX2(OPC_SUB, _mm256_sub_pd)
+		APPLY_AVX2(OPC_MUL, _mm256_mul_pd)
+		APPLY_AVX2(OPC_DIV, _mm256_div_pd)
+#undef APPLY_AVX2
+
+		case OPC_NEG:
+		{
+			const __m256d sign = _mm256_set1_pd(-0.0);
+			for (; i + 4 <= count; i += 4)
+			{
+				_mm256_storeu_pd(lhs + i, _mm256_xor_pd(_mm256_loadu_pd(lhs + i), sign));
+			}
+		} break;
+
+		case OPC_SQRT:
+		{
+			for (; i + 4 <= count; i += 4)
+			{
+				_mm256_storeu_pd(lhs + i, _mm256_sqrt_pd(_mm256_loadu_pd(lhs + i)));
+			}
+		} break;
+
+		default:
+			break;
+	}
+
+	if (i < count) ApplyScalar(opcode, lhs + i, IsUnary(opcode) ? NULL : rhs + i, count - i);
+}
+
+#endif // CPU_X86
+
+ColumnsKernel ColumnsUseKernel(ColumnsKernel preferred)
+{
+	ColumnsKernel kernel = COLUMNS_KERNEL_SCALAR;
+
+#if CPU_X86
+	// SSE2 is part of the x86-64 baseline.
+	kernel = COLUMNS_KERNEL_SSE2;
+	if (CpuHasAvx2()) kernel = COLUMNS_KERNEL_AVX2;
+#endif
+
+	if (kernel > preferred) kernel = preferred;
+
+	switch (kernel)
+	{
+#if CPU_X86
+		case COLUMNS_KERNEL_AVX2: applyKernel = ApplyAvx2; break;
+		case COLUMNS_KERNEL_SSE2: applyKernel = ApplySse2; break;
+#endif
+		default: applyKernel = ApplyScalar; break;
+	}
+
+	return kernel;
+}
+
+void ColumnsPrepare(void)
+{
+	if (applyKernel == ApplyResolve) ColumnsUseKernel(COLUMNS_KERNEL_AVX2);
+}
+
+static void ApplyResolve(Opcode opcode, double *lhs, const double *rhs, size_t count)
+{
+	ColumnsUseKernel(COLUMNS_KERNEL_AVX2);
+	applyKernel(opcode, lhs, rhs, count);
+}
+
+static void Fill(double *values, double value, size_t count)
+{
+	for (size_t i = 0; i < count; ++i) values[i] = value;
+}
+
+// PowHalves over a block, with the same operations in the same order so
+// the results agree with the other engines. base and root are scratch
+// blocks.
+static void PowHalvesBlock(double *values, double *base, double *root, size_t count, int halves)
+{
+	unsigned n = halves < 0 ? -(unsigned)halves : (unsigned)halves;
+	unsigned whole = n >> 1;
+
+	memcpy(base, values, count * sizeof(*base));
+
+	if (whole)
+	{
+		unsigned bit = 1;
+		while (bit <= whole >> 1) bit <<= 1;
+
+		for (bit >>= 1; bit; bit >>= 1)
+		{
+			applyKernel(OPC_MUL, values, values, count);
+			if (whole & bit) applyKernel(OPC_MUL, values, base, count);
+		}
+	}
+	else
+	{
+		Fill(values, 1, count);
+	}
+
+	if (n & 1)
+	{
+		memcpy(root, base, count * sizeof(*root));
+		applyKernel(OPC_SQRT, root, NULL, count);
+		if (whole) applyKernel(OPC_MUL, values, root, count);
+		else memcpy(values, root, count * sizeof(*values));
+	}
+
+	if (halves < 0)
+	{
+		Fill(root, 1, count);
+		applyKernel(OPC_DIV, root, values, count);
+		memcpy(values, root, count * sizeof(*values));
+	}
+}
+
+void RunProgramColumns(const Program *program, const double *const *columns, double *results, size_t rowCount)
+{
+	if (rowCount == 0) return;
+
+	int variableCount = program->variableCount;
+
+	// One block of rows per stack entry, one per variable to hold the values
+	// assigned in the current block, and two of scratch for OPC_POWN.
+	double *stack = malloc((program->maxStackDepth + variableCount + 2) * BLOCK_ROWS * sizeof(*stack));
+	const double **sources = malloc((variableCount ? variableCount : 1) * sizeof(*sources));
+	assert(stack && sources && "Out of memory");
+
+	double *assigned = stack + program->maxStackDepth * BLOCK_ROWS;
+	double *scratch = assigned + variableCount * BLOCK_ROWS;
+
+	const Instruction *code = program->code;
+	const Instruction *end = code + program->codeLen;
+	const double *constants = program->constants;
+
+	for (size_t blockStart = 0; blockStart < rowCount; blockStart += BLOCK_ROWS)
+	{
+		size_t count = rowCount - blockStart;
+		if (count > BLOCK_ROWS) count = BLOCK_ROWS;
+
+		// Variables read from their columns until assigned.
+		for (int slot = 0; slot < variableCount; ++slot)
+		{
+			sources[slot] = columns[slot] ? columns[slot] + blockStart : NULL;
+		}
+
+		// sp points at the top block of the stack.
+		double *sp = stack - BLOCK_ROWS;
+
+		for (const Instruction *ip = code; ip < end; ++ip)
+		{
+			Instruction instruction = *ip;
+			Opcode opcode = INSTRUCTION_OPCODE(instruction);
+
+			switch (opcode)
+			{
+				case OPC_PUSH:
+				{
+					double value = constants[INSTRUCTION_OPERAND(instruction)];
+					sp += BLOCK_ROWS;
+					for (size_t i = 0; i < count; ++i) sp[i] = value;
+				} break;
+
+				case OPC_LOAD:
+				{
+					const double *source = sources[INSTRUCTION_OPERAND(instruction)];
+					sp += BLOCK_ROWS;
+					if (source) memcpy(sp, source, count * sizeof(*sp));
+					else memset(sp, 0, count * sizeof(*sp));
+				} break;
+
+				case OPC_STORE:
+				{
+					int slot = INSTRUCTION_OPERAND(instruction);
+					double *target = assigned + slot * BLOCK_ROWS;
+					memcpy(target, sp, count * sizeof(*sp));
+					sources[slot] = target;
+				} break;
+
+				case OPC_NEG:
+				case OPC_SQRT:
+				{
+					applyKernel(opcode, sp, NULL, count);
+				} break;
+
+				case OPC_POWN:
+				{
+					int halves = INSTRUCTION_SIGNED_OPERAND(instruction);
+					PowHalvesBlock(sp, scratch, scratch + BLOCK_ROWS, count, halves);
+				} break;
+
+				default:
+				{
+					applyKernel(opcode, sp - BLOCK_ROWS, sp, count);
+					sp -= BLOCK_ROWS;
+				} break;
+			}
+		}
+
+		assert(sp == stack);
+		memcpy(results + blockStart, sp, count * sizeof(*results));
+	}
+
+	free(sources);
+	free(stack);
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+#ifndef COLUMNS_H
+#define COLUMNS_H
+
+#include <stddef.h>
+
+#include "bytecode.h"
+
+// Columnar evaluation: runs a program over many rows of variable values at
+// once. Every instruction is applied to a block of rows before moving on to
+// the next, so the dispatch cost is paid once per block instead of once per
+// row and the arithmetic runs in SIMD lanes. Has a scalar, an SSE2 and an
+// AVX2 kernel; the best one the CPU supports is picked on first use.
+
+typedef enum
+{
+	COLUMNS_KERNEL_SCALAR,
+	COLUMNS_KERNEL_SSE2,
+	COLUMNS_KERNEL_AVX2,
+} ColumnsKernel;
+
+// Uses the best supported kernel no better than preferred, and returns it.
+ColumnsKernel ColumnsUseKernel(ColumnsKernel preferred);
+
+// Picks the best kernel now if no run has picked one yet. Call it before
+// running programs over columns on several threads at once.
+void ColumnsPrepare(void);
+
+// Sets results[row] to the value of the program for every row below
+// rowCount. columns[slot] holds the rowCount values of variable slot, one
+// column for each of the program's variableCount. A NULL column reads as 0.
+// Assignments only affect the rest of their own row; the columns are not
+// written to. Gives the same results as RunProgram row by row.
+void RunProgramColumns(const Program *program, const double *const *columns, double *results, size_t rowCount);
+
+#endif
\ No newline at end of file
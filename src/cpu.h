@@ -0,0 +1,26 @@
+#ifndef CPU_H
+#define CPU_H
+
+#include <stdbool.h>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define CPU_X86 1
+#else
+#define CPU_X86 0
+#endif
+
+// Functions using AVX2 intrinsics are compiled for it one by one, so the
+// rest of the program still runs on any x86-64.
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_AVX2
+#endif
+
+// True if both the CPU and the OS support AVX2. Always false off x86-64.
+bool CpuHasAvx2(void);
+
+// Logical processors available to the process, at least 1.
+int CpuCount(void);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,10 @@
+#ifndef DECIMAL_H
+#define DECIMAL_H
+
+// Converts the decimal literal in [start, end) to the nearest double (ties
+// to even). The literal is digits with at most one '.', of any length, as
+// produced by the tokenizer. Does not allocate and does not depend on the
+// locale.
+double ParseDecimal(const char *start, const char *end);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,257 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "input.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <io.h>
+#define read _read
+#define fileno _fileno
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define INPUT_CHUNK_SIZE (64*1024)
+
+// Reads whatever is available, up to size, without waiting for more.
+// Returns 0 at the end of the input and -1 on failure.
+static long ReadSome(FILE *file, char *dest, size_t size)
+{
+	// read takes an unsigned count on Windows and returns an int there, so
+	// larger requests are cut down, not truncated to their low bits.
+	if (size > INT_MAX) size = INT_MAX;
+
+	for (;;)
+	{
+		long n = (long)read(fileno(file), dest, (unsigned)size);
+		if (n >= 0 || errno != EINTR) return n;
+	}
+}
+
+int ReadEntireFile(FILE *file, char **contents, size_t *contentsLen)
+{
+	*contents = NULL;
+	*contentsLen = 0;
+	if (!file) return -1;
+
+	// No fseek/ftell: the size of a pipe is not known up front.
+	size_t capacity = INPUT_CHUNK_SIZE;
+	size_t len = 0;
+	char *buffer = malloc(capacity + 1);
+	if (!buffer) goto error;
+
+	for (;;)
+	{
+		if (len == capacity)
+		{
+			capacity *= 2;
+			char *grown = realloc(buffer, capacity + 1);
+			if (!grown) goto error;
+			buffer = grown;
+		}
+
+		long n = ReadSome(file, buffer + len, capacity - len);
+		if (n < 0) goto error;
+		if (n == 0) break;
+		len += n;
+	}
+
+	buffer[len] = '\0';
+	*contents = buffer;
+	*contentsLen = len;
+	return 0;
+
+error:
+	fprintf(stderr, "[ERROR] Could not read file: %s\n", strerror(errno));
+	if (file != stdin) fclose(file);
+	free(buffer);
+	return -1;
+}
+
+#ifdef _WIN32
+
+bool MapFile(FILE *file, MappedFile *mapped)
+{
+	*mapped = (MappedFile){0};
+
+	HANDLE handle = (HANDLE)_get_osfhandle(fileno(file));
+	if (handle == INVALID_HANDLE_VALUE || GetFileType(handle) != FILE_TYPE_DISK) return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(handle, &size)) return false;
+
+	if (size.QuadPart == 0)
+	{
+		mapped->data = "";
+		return true;
+	}
+
+	HANDLE mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!mapping) return false;
+
+	const char *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!data)
+	{
+		CloseHandle(mapping);
+		return false;
+	}
+
+	mapped->data = data;
+	mapped->len = (size_t)size.QuadPart;
+	mapped->mapping = mapping;
+	return true;
+}
+
+void UnmapFile(MappedFile *mapped)
+{
+	if (mapped->mapping)
+	{
+		UnmapViewOfFile(mapped->data);
+		CloseHandle(mapped->mapping);
+	}
+	*mapped = (MappedFile){0};
+}
+
+#else
+
+bool MapFile(FILE *file, MappedFile *mapped)
+{
+	*mapped = (MappedFile){0};
+
+	int fd = fileno(file);
+	struct stat info;
+	if (fstat(fd, &info) < 0 || !S_ISREG(info.st_mode)) return false;
+
+	// mmap refuses zero length mappings.
+	if (info.st_size == 0)
+	{
+		mapped->data = "";
+		return true;
+	}
+
+	void *data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (data == MAP_FAILED) return false;
+
+	// The tokenizer reads front to back exactly once.
+	posix_madvise(data, (size_t)info.st_size, POSIX_MADV_SEQUENTIAL);
+
+	mapped->data = data;
+	mapped->len = (size_t)info.st_size;
+	mapped->mapping = data;
+	return true;
+}
+
+void UnmapFile(MappedFile *mapped)
+{
+	if (mapped->mapping) munmap(mapped->mapping, mapped->len);
+	*mapped = (MappedFile){0};
+}
+
+#endif
+
+LineReader LineReaderFromFile(FILE *file)
+{
+	return (LineReader){.file = file};
+}
+
+LineReader LineReaderFromBuffer(const char *buffer, size_t len)
+{
+	return (LineReader){
+		.buffer = (char *)buffer,
+		.len = len,
+		.eof = true,
+	};
+}
+
+static void Refill(LineReader *reader)
+{
+	size_t pending = reader->len - reader->start;
+
+	// Move the partial line to the front to make room behind it.
+	if (reader->start > 0)
+	{
+		memmove(reader->buffer, reader->buffer + reader->start, pending);
+		reader->start = 0;
+		reader->len = pending;
+	}
+
+	// Only a line longer than the buffer makes it grow.
+	if (reader->len == reader->capacity)
+	{
+		size_t capacity = reader->capacity ? 2*reader->capacity : INPUT_CHUNK_SIZE;
+		char *grown = realloc(reader->buffer, capacity);
+		if (!grown)
+		{
+			reader->eof = reader->failed = true;
+			return;
+		}
+		reader->buffer = grown;
+		reader->capacity = capacity;
+	}
+
+	if (reader->flushBeforeRead) fflush(reader->flushBeforeRead);
+
+	long n = ReadSome(reader->file, reader->buffer + reader->len, reader->capacity - reader->len);
+	if (n < 0)
+	{
+		fprintf(stderr, "[ERROR] Could not read file: %s\n", strerror(errno));
+		reader->failed = true;
+	}
+
+	if (n <= 0) reader->eof = true;
+	else reader->len += n;
+}
+
+bool ReadLine(LineReader *reader, const char **line, size_t *lineLen)
+{
+	for (;;)
+	{
+		char *start = reader->buffer + reader->start;
+		size_t pending = reader->len - reader->start;
+
+		char *newline = NULL;
+		if (pending > reader->scanned)
+		{
+			newline = memchr(start + reader->scanned, '\n', pending - reader->scanned);
+		}
+		if (newline)
+		{
+			*line = start;
+			*lineLen = newline - start;
+			reader->start += *lineLen + 1;
+			reader->scanned = 0;
+			return true;
+		}
+
+		reader->scanned = pending;
+
+		if (reader->eof)
+		{
+			// The last line need not end with a newline.
+			if (pending == 0) return false;
+
+			*line = start;
+			*lineLen = pending;
+			reader->start = reader->len;
+			reader->scanned = 0;
+			return true;
+		}
+
+		Refill(reader);
+	}
+}
+
+void LineReaderFree(LineReader *reader)
+{
+	if (reader->capacity) free(reader->buffer);
+	*reader = (LineReader){0};
+}
\ No newline at end of file
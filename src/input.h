@@ -0,0 +1,55 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+// Reads a file or pipe (stdin included) to the end into a malloced,
+// null-terminated buffer. Returns -1 on failure.
+int ReadEntireFile(FILE *file, char **contents, size_t *contentsLen);
+
+// A regular file mapped read-only into memory.
+typedef struct MappedFile_t
+{
+	const char *data;
+	size_t len;
+	void *mapping; // Platform handle, NULL for an empty file
+} MappedFile;
+
+// Maps a regular file so it can be tokenized in place, without a copy, and
+// with the pages shared with other processes reading the same file.
+// Returns false for pipes, terminals and anything else that cannot be
+// mapped; read those instead.
+bool MapFile(FILE *file, MappedFile *mapped);
+void UnmapFile(MappedFile *mapped);
+
+// Hands out the lines of a file or pipe as they arrive, holding only the
+// unconsumed part of the input in memory.
+typedef struct LineReader_t
+{
+	FILE *file;
+	FILE *flushBeforeRead; // Flushed before blocking on more input, if set
+
+	char *buffer;
+	size_t capacity; // Zero when buffer is not owned by the reader
+	size_t start;    // First character not yet handed out
+	size_t scanned;  // Characters from start known to hold no newline
+	size_t len;      // End of the characters read so far
+
+	bool eof;
+	bool failed;
+} LineReader;
+
+LineReader LineReaderFromFile(FILE *file);
+
+// Reads lines out of a complete input already in memory.
+LineReader LineReaderFromBuffer(const char *buffer, size_t len);
+
+// Returns false at the end of the input. The line, without its newline, is
+// valid until the next call.
+bool ReadLine(LineReader *reader, const char **line, size_t *lineLen);
+
+void LineReaderFree(LineReader *reader);
+
+#endif
\ No newline at end of file
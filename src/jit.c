@@ -0,0 +1,523 @@
+// For MAP_ANONYMOUS, which POSIX leaves out.
+#define _DEFAULT_SOURCE
+
+#include "jit.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if (defined(__x86_64__) || defined(_M_X64)) && !defined(_WIN32)
+#define JIT_SUPPORTED 1
+#include <sys/mman.h>
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#else
+#define JIT_SUPPORTED 0
+#endif
+
+#if JIT_SUPPORTED
+
+// Scalar double instructions, all F2 0F <op>.
+enum
+{
+	SD_LOAD = 0x10,
+	SD_STORE = 0x11,
+	SD_ADD = 0x58,
+	SD_MUL = 0x59,
+	SD_SUB = 0x5c,
+	SD_DIV = 0x5e,
+	SD_SQRT = 0x51,
+};
+
+enum
+{
+	REG_RSP = 4,
+	REG_RBX = 3,
+};
+
+typedef struct Fixup_t
+{
+	size_t at; // Offset of a disp32 relative to the end of its instruction
+	int constant;
+} Fixup;
+
+typedef struct Assembler_t
+{
+	unsigned char *code;
+	size_t len;
+	size_t capacity;
+
+	double *constants;
+	int constantCount;
+	int constantCapacity;
+
+	// Open addressing table of constant indices by bit pattern, -1 if empty.
+	int *buckets;
+	size_t bucketCount; // A power of two
+
+	Fixup *fixups;
+	int fixupCount;
+	int fixupCapacity;
+
+	int maxSpills; // Stack slots of 8 bytes the frame needs
+} Assembler;
+
+static void Bytes(Assembler *as, const void *bytes, size_t count)
+{
+	if (as->len + count > as->capacity)
+	{
+		as->capacity = as->capacity ? 2*as->capacity : 256;
+		if (as->capacity < as->len + count) as->capacity = as->len + count;
+		as->code = realloc(as->code, as->capacity);
+		assert(as->code && "Out of memory");
+	}
+
+	memcpy(as->code + as->len, bytes, count);
+	as->len += count;
+}
+
+static void Byte(Assembler *as, unsigned char byte)
+{
+	Bytes(as, &byte, 1);
+}
+
+static void Int32(Assembler *as, int32_t value)
+{
+	Bytes(as, &value, sizeof(value));
+}
+
+static uint64_t ConstantBits(double value)
+{
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+
+static size_t HashConstant(uint64_t bits)
+{
+	// The splitmix64 finalizer. Doubles tend to differ in their high bits,
+	// which it spreads over the low ones the buckets are picked by.
+	bits ^= bits >> 30;
+	bits *= UINT64_C(0xbf58476d1ce4e5b9);
+	bits ^= bits >> 27;
+	bits *= UINT64_C(0x94d049bb133111eb);
+	bits ^= bits >> 31;
+	return (size_t)bits;
+}
+
+// Returns the bucket holding the constant, or the empty bucket it would go in.
+static size_t FindConstant(const Assembler *as, uint64_t bits)
+{
+	size_t mask = as->bucketCount - 1;
+
+	for (size_t bucket = HashConstant(bits) & mask;; bucket = (bucket + 1) & mask)
+	{
+		int constant = as->buckets[bucket];
+		if (constant < 0 || ConstantBits(as->constants[constant]) == bits) return bucket;
+	}
+}
+
+static void RehashConstants(Assembler *as, size_t bucketCount)
+{
+	free(as->buckets);
+	as->bucketCount = bucketCount;
+	as->buckets = malloc(bucketCount * sizeof(*as->buckets));
+	assert(as->buckets && "Out of memory");
+	memset(as->buckets, 0xff, bucketCount * sizeof(*as->buckets));
+
+	for (int constant = 0; constant < as->constantCount; ++constant)
+	{
+		as->buckets[FindConstant(as, ConstantBits(as->constants[constant]))] = constant;
+	}
+}
+
+static int AddConstant(Assembler *as, double value)
+{
+	// Identical constants share a slot; compare bits so -0 and 0 do not.
+	if (2*(size_t)(as->constantCount + 1) > as->bucketCount)
+	{
+		RehashConstants(as, as->bucketCount ? 2*as->bucketCount : 64);
+	}
+
+	uint64_t bits = ConstantBits(value);
+	size_t bucket = FindConstant(as, bits);
+	if (as->buckets[bucket] >= 0) return as->buckets[bucket];
+
+	if (as->constantCount == as->constantCapacity)
+	{
+		as->constantCapacity = as->constantCapacity ? 2*as->constantCapacity : 16;
+		as->constants = realloc(as->constants, as->constantCapacity * sizeof(*as->constants));
+		assert(as->constants && "Out of memory");
+	}
+
+	as->constants[as->constantCount] = value;
+	as->buckets[bucket] = as->constantCount;
+	return as->constantCount++;
+}
+
+// op xmm, [rip + constant]
+static void SdConstant(Assembler *as, int op, int xmm, double value)
+{
+	int constant = AddConstant(as, value);
+
+	Bytes(as, (unsigned char[]){0xf2, 0x0f, (unsigned char)op, (unsigned char)(0x05 | xmm << 3)}, 4);
+
+	if (as->fixupCount == as->fixupCapacity)
+	{
+		as->fixupCapacity = as->fixupCapacity ? 2*as->fixupCapacity : 16;
+		as->fixups = realloc(as->fixups, as->fixupCapacity * sizeof(*as->fixups));
+		assert(as->fixups && "Out of memory");
+	}
+	as->fixups[as->fixupCount++] = (Fixup){.at = as->len, .constant = constant};
+
+	Int32(as, 0);
+}
+
+// op xmm, [base + disp32] (or the reverse for SD_STORE)
+static void SdMemory(Assembler *as, int op, int xmm, int base, int32_t disp)
+{
+	Bytes(as, (unsigned char[]){0xf2, 0x0f, (unsigned char)op, (unsigned char)(0x80 | xmm << 3 | base)}, 4);
+	if (base == REG_RSP) Byte(as, 0x24); // SIB: no index
+	Int32(as, disp);
+}
+
+// op dst, src
+static void SdRegister(Assembler *as, int op, int dst, int src)
+{
+	Bytes(as, (unsigned char[]){0xf2, 0x0f, (unsigned char)op, (unsigned char)(0xc0 | dst << 3 | src)}, 4);
+}
+
+static void NegateXmm0(Assembler *as)
+{
+	static const unsigned char code[] = {
+		0x66, 0x48, 0x0f, 0x7e, 0xc0, // movq rax, xmm0
+		0x48, 0x0f, 0xba, 0xf8, 0x3f, // btc rax, 63
+		0x66, 0x48, 0x0f, 0x6e, 0xc0, // movq xmm0, rax
+	};
+	Bytes(as, code, sizeof(code));
+}
+
+static void CallPow(Assembler *as)
+{
+	double (*powFn)(double, double) = pow;
+	uint64_t address = (uint64_t)(uintptr_t)powFn;
+
+	Bytes(as, (unsigned char[]){0x48, 0xb8}, 2); // mov rax, imm64
+	Bytes(as, &address, sizeof(address));
+	Bytes(as, (unsigned char[]){0xff, 0xd0}, 2); // call rax
+}
+
+static void MoveXmm(Assembler *as, int dst, int src)
+{
+	Bytes(as, (unsigned char[]){0x66, 0x0f, 0x28, (unsigned char)(0xc0 | dst << 3 | src)}, 4); // movapd
+}
+
+// xmm0 = xmm0^(halves/2), inline, with the operations of PowHalves.
+static void PowHalvesXmm0(Assembler *as, int halves)
+{
+	unsigned n = halves < 0 ? -(unsigned)halves : (unsigned)halves;
+	unsigned whole = n >> 1;
+
+	MoveXmm(as, 1, 0); // base
+
+	if (whole)
+	{
+		unsigned bit = 1;
+		while (bit <= whole >> 1) bit <<= 1;
+
+		for (bit >>= 1; bit; bit >>= 1)
+		{
+			SdRegister(as, SD_MUL, 0, 0);
+			if (whole & bit) SdRegister(as, SD_MUL, 0, 1);
+		}
+	}
+	else
+	{
+		SdConstant(as, SD_LOAD, 0, 1);
+	}
+
+	if (n & 1)
+	{
+		if (whole)
+		{
+			SdRegister(as, SD_SQRT, 2, 1);
+			SdRegister(as, SD_MUL, 0, 2);
+		}
+		else
+		{
+			SdRegister(as, SD_SQRT, 0, 1);
+		}
+	}
+
+	if (halves < 0)
+	{
+		SdConstant(as, SD_LOAD, 1, 1);
+		SdRegister(as, SD_DIV, 1, 0);
+		MoveXmm(as, 0, 1);
+	}
+}
+
+static int SdOpcode(Operator op)
+{
+	switch (op)
+	{
+		case OP_ADD: return SD_ADD;
+		case OP_MINUS: return SD_SUB;
+		case OP_MULTIPLY: return SD_MUL;
+		case OP_DIVIDE: return SD_DIV;
+		default:
+			assert(0 && "Invalid code path!");
+			return 0;
+	}
+}
+
+// A number or a plain variable can be an instruction's memory operand.
+static bool IsOperand(const Expr *expr)
+{
+	return expr->type == EXPR_NUMBER
+		|| (expr->type == EXPR_VARIABLE && !(expr->flags & EXPR_FLAG_NEGATED));
+}
+
+static void SdOperand(Assembler *as, int op, int xmm, const Expr *operand)
+{
+	if (operand->type == EXPR_NUMBER)
+	{
+		double value = operand->as.number;
+		SdConstant(as, op, xmm, (operand->flags & EXPR_FLAG_NEGATED) ? -value : value);
+	}
+	else
+	{
+		SdMemory(as, op, xmm, REG_RBX, operand->as.variable.slot * (int32_t)sizeof(double));
+	}
+}
+
+// Spill slots a frame may have at most. The frame lives on the caller's
+// stack, so expressions that would need more fall back to the VM.
+#define JIT_MAX_SPILLS 4096
+
+// Leaves the value of expr in xmm0. Walks the tree with its own stack, like
+// PrintExpr; each operator is visited before its operands, between them and
+// after them.
+static void GenExpr(Assembler *as, const Expr *expr)
+{
+	typedef struct { const Expr *expr; int spills; int visits; } GenFrame;
+
+	GenFrame *stack = NULL;
+	size_t capacity = 0;
+	size_t depth = 0;
+	const Expr *next = expr;
+	int nextSpills = 0; // Spill slots in use below next
+
+	for (;;)
+	{
+		if (next)
+		{
+			if (depth == capacity)
+			{
+				capacity = capacity ? 2*capacity : 64;
+				stack = realloc(stack, capacity * sizeof(*stack));
+				assert(stack && "Out of memory");
+			}
+			stack[depth++] = (GenFrame){next, nextSpills, 0};
+			next = NULL;
+		}
+
+		if (depth == 0) break;
+
+		GenFrame *top = &stack[depth - 1];
+		const Expr *node = top->expr;
+		bool done = true;
+
+		switch (node->type)
+		{
+			case EXPR_NUMBER:
+			case EXPR_VARIABLE:
+			{
+				SdOperand(as, SD_LOAD, 0, node);
+			} break;
+
+			case EXPR_BINOP:
+			{
+				const BinNode *bn = &node->as.binop;
+				int halves;
+
+				if (bn->op == OP_ASSIGN)
+				{
+					if (top->visits++ == 0)
+					{
+						next = bn->rhs;
+						nextSpills = top->spills;
+						done = false;
+						break;
+					}
+					SdMemory(as, SD_STORE, 0, REG_RBX, bn->lhs->as.variable.slot * (int32_t)sizeof(double));
+					break;
+				}
+
+				// Park the left hand side while the right hand side is
+				// computed; every register is clobbered by calls to pow.
+				int32_t spill = top->spills * (int32_t)sizeof(double);
+
+				switch (top->visits++)
+				{
+					case 0:
+						next = bn->lhs;
+						nextSpills = top->spills;
+						done = false;
+						break;
+
+					case 1:
+						if (bn->op == OP_EXP && ExprConstantHalves(bn->rhs, &halves))
+						{
+							PowHalvesXmm0(as, halves);
+							break;
+						}
+
+						if (IsOperand(bn->rhs))
+						{
+							if (bn->op == OP_EXP)
+							{
+								SdOperand(as, SD_LOAD, 1, bn->rhs);
+								CallPow(as);
+							}
+							else
+							{
+								SdOperand(as, SdOpcode(bn->op), 0, bn->rhs);
+							}
+							break;
+						}
+
+						if (top->spills + 1 > as->maxSpills) as->maxSpills = top->spills + 1;
+
+						SdMemory(as, SD_STORE, 0, REG_RSP, spill);
+						next = bn->rhs;
+						nextSpills = top->spills + 1;
+						done = false;
+						break;
+
+					default:
+						MoveXmm(as, 1, 0);
+						SdMemory(as, SD_LOAD, 0, REG_RSP, spill);
+
+						if (bn->op == OP_EXP) CallPow(as);
+						else SdRegister(as, SdOpcode(bn->op), 0, 1);
+						break;
+				}
+			} break;
+
+			default:
+				assert(0 && "Invalid code path!");
+				break;
+		}
+
+		if (!done) continue;
+
+		// A number has its sign folded into the constant.
+		if ((node->flags & EXPR_FLAG_NEGATED) && node->type != EXPR_NUMBER) NegateXmm0(as);
+		--depth;
+	}
+
+	free(stack);
+}
+
+bool JitCompile(Expr *expr, JitCode *code)
+{
+	*code = (JitCode){0};
+
+	Assembler as = {0};
+
+	// push rbx; mov rbx, rdi; sub rsp, frame
+	// rbx holds the variables across calls to pow. The frame size is patched
+	// in once the number of spill slots is known.
+	Bytes(&as, (unsigned char[]){0x53, 0x48, 0x89, 0xfb, 0x48, 0x81, 0xec}, 7);
+	size_t frameAt = as.len;
+	Int32(&as, 0);
+
+	GenExpr(&as, expr);
+
+	if (as.maxSpills > JIT_MAX_SPILLS)
+	{
+		free(as.code);
+		free(as.constants);
+		free(as.buckets);
+		free(as.fixups);
+		return false;
+	}
+
+	// add rsp, frame; pop rbx; ret
+	Bytes(&as, (unsigned char[]){0x48, 0x81, 0xc4}, 3);
+	size_t frameAt2 = as.len;
+	Int32(&as, 0);
+	Bytes(&as, (unsigned char[]){0x5b, 0xc3}, 2);
+
+	// With rbx pushed the stack is 16 byte aligned, as calls need, so the
+	// frame is kept a multiple of 16.
+	int32_t frame = (int32_t)((as.maxSpills * sizeof(double) + 15) & ~(size_t)15);
+	memcpy(as.code + frameAt, &frame, sizeof(frame));
+	memcpy(as.code + frameAt2, &frame, sizeof(frame));
+
+	size_t poolAt = (as.len + 7) & ~(size_t)7;
+	size_t size = poolAt + as.constantCount * sizeof(double);
+
+	for (int i = 0; i < as.fixupCount; ++i)
+	{
+		Fixup fixup = as.fixups[i];
+		int32_t disp = (int32_t)(poolAt + fixup.constant * sizeof(double) - (fixup.at + 4));
+		memcpy(as.code + fixup.at, &disp, sizeof(disp));
+	}
+
+	// Written while writable, then made executable; never both at once.
+	void *memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	bool mapped = memory != MAP_FAILED;
+
+	if (mapped)
+	{
+		memcpy(memory, as.code, as.len);
+		memset((char *)memory + as.len, 0xcc, poolAt - as.len); // int3
+		memcpy((char *)memory + poolAt, as.constants, as.constantCount * sizeof(double));
+
+		if (mprotect(memory, size, PROT_READ | PROT_EXEC) == 0)
+		{
+			code->memory = memory;
+			code->size = size;
+			code->fn = (JitFn *)(uintptr_t)memory;
+		}
+		else
+		{
+			munmap(memory, size);
+			mapped = false;
+		}
+	}
+
+	free(as.code);
+	free(as.constants);
+	free(as.buckets);
+	free(as.fixups);
+	return mapped;
+}
+
+void JitFree(JitCode *code)
+{
+	if (code->memory) munmap(code->memory, code->size);
+	*code = (JitCode){0};
+}
+
+#else
+
+bool JitCompile(Expr *expr, JitCode *code)
+{
+	(void)expr;
+	*code = (JitCode){0};
+	return false;
+}
+
+void JitFree(JitCode *code)
+{
+	*code = (JitCode){0};
+}
+
+#endif
\ No newline at end of file
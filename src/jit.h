@@ -0,0 +1,30 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "parser.h"
+
+// Compiles an expression tree to x86-64 machine code. Intermediate values
+// live in SSE2 registers and a small stack frame, numbers in a literal pool
+// after the code, and variables are read from and written to the array
+// passed in.
+
+typedef double JitFn(double *variables);
+
+typedef struct JitCode_t
+{
+	JitFn *fn;
+	void *memory; // Executable mapping holding the code and literal pool
+	size_t size;
+} JitCode;
+
+// Returns false where there is no JIT (anything but x86-64 with the System
+// V calling convention), executable memory could not be had, or the right
+// hand sides nest too deep for the stack frame. Use the bytecode VM then.
+bool JitCompile(Expr *expr, JitCode *code);
+
+void JitFree(JitCode *code);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,198 @@
+#include "optimize.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+static bool IsNumber(const Expr *expr, double value)
+{
+	return expr->type == EXPR_NUMBER && expr->as.number == value;
+}
+
+// Numbers carry their sign in the value, never in the flag.
+static Expr *FoldNegatedNumber(Expr *expr)
+{
+	if (expr->type == EXPR_NUMBER && (expr->flags & EXPR_FLAG_NEGATED))
+	{
+		expr->as.number = -expr->as.number;
+		expr->flags &= ~EXPR_FLAG_NEGATED;
+	}
+	return expr;
+}
+
+// Replaces expr by one of its operands, keeping expr's negation.
+static Expr *Replace(Expr *expr, Expr *operand)
+{
+	operand->flags ^= expr->flags & EXPR_FLAG_NEGATED;
+	return FoldNegatedNumber(operand);
+}
+
+static Expr *MakeNumber(Expr *expr, double value)
+{
+	if (expr->flags & EXPR_FLAG_NEGATED) value = -value;
+	expr->type = EXPR_NUMBER;
+	expr->flags &= ~EXPR_FLAG_NEGATED;
+	expr->as.number = value;
+	return expr;
+}
+
+static double Apply(Operator op, double lhs, double rhs)
+{
+	// The same operations as EvalExpr, so folding does not change results.
+	switch (op)
+	{
+		case OP_ADD: return lhs + rhs;
+		case OP_MINUS: return lhs - rhs;
+		case OP_MULTIPLY: return lhs * rhs;
+		case OP_DIVIDE: return lhs / rhs;
+		case OP_EXP: return pow(lhs, rhs);
+		default:
+			assert(0 && "Invalid code path!");
+			return 0;
+	}
+}
+
+// Simplifies expr, whose operands have been optimized already.
+// lhsHasAssignment tells whether there is an assignment in its left operand.
+static Expr *OptimizeNode(Expr *expr, bool lhsHasAssignment)
+{
+	if (expr->type == EXPR_NUMBER) return FoldNegatedNumber(expr);
+	if (expr->type != EXPR_BINOP) return expr;
+
+	BinNode *bn = &expr->as.binop;
+
+	if (bn->op == OP_ASSIGN) return expr;
+
+	Expr *lhs = bn->lhs;
+	Expr *rhs = bn->rhs;
+
+	if (lhs->type == EXPR_NUMBER && rhs->type == EXPR_NUMBER)
+	{
+		int halves;
+		if (bn->op == OP_EXP && ExprConstantHalves(rhs, &halves)) return MakeNumber(expr, PowHalves(lhs->as.number, halves));
+		return MakeNumber(expr, Apply(bn->op, lhs->as.number, rhs->as.number));
+	}
+
+	bool lhsNegated = lhs->flags & EXPR_FLAG_NEGATED;
+	bool rhsNegated = rhs->flags & EXPR_FLAG_NEGATED;
+
+	switch (bn->op)
+	{
+		case OP_ADD:
+		case OP_MINUS:
+		{
+			if (IsNumber(rhs, 0)) return Replace(expr, lhs);
+			if (bn->op == OP_ADD && IsNumber(lhs, 0)) return Replace(expr, rhs);
+
+			if (IsNumber(lhs, 0))
+			{
+				// 0 - x
+				expr->flags ^= EXPR_FLAG_NEGATED;
+				return Replace(expr, rhs);
+			}
+
+			// a + -b is a - b, a - -b is a + b
+			if (rhsNegated)
+			{
+				rhs->flags &= ~EXPR_FLAG_NEGATED;
+				bn->op = bn->op == OP_ADD ? OP_MINUS : OP_ADD;
+			}
+		} break;
+
+		case OP_MULTIPLY:
+		case OP_DIVIDE:
+		{
+			if (IsNumber(rhs, 1)) return Replace(expr, lhs);
+			if (bn->op == OP_MULTIPLY && IsNumber(lhs, 1)) return Replace(expr, rhs);
+
+			if (IsNumber(rhs, -1) || (bn->op == OP_MULTIPLY && IsNumber(lhs, -1)))
+			{
+				expr->flags ^= EXPR_FLAG_NEGATED;
+				return Replace(expr, IsNumber(rhs, -1) ? lhs : rhs);
+			}
+
+			// The sign of a product or quotient is independent of its
+			// magnitude, so negations move up to the result, where two of
+			// them cancel.
+			if (lhsNegated) lhs->flags &= ~EXPR_FLAG_NEGATED;
+			if (rhsNegated) rhs->flags &= ~EXPR_FLAG_NEGATED;
+			if (lhsNegated != rhsNegated) expr->flags ^= EXPR_FLAG_NEGATED;
+		} break;
+
+		case OP_EXP:
+		{
+			if (IsNumber(rhs, 1)) return Replace(expr, lhs);
+
+			// pow(x, 0) is 1 for every x, NaN included.
+			if (IsNumber(rhs, 0) && !lhsHasAssignment) return MakeNumber(expr, 1);
+		} break;
+
+		default:
+			assert(0 && "Invalid code path!");
+	}
+
+	return expr;
+}
+
+// A subtree optimized already, on the stack of OptimizeExpr.
+typedef struct Optimized_t
+{
+	Expr *expr;
+	bool hasAssignment;
+} Optimized;
+
+// Optimizes the nodes in post order, so both operands of an operator are
+// done before it, however deep the tree is. The optimized operands wait on
+// a stack, as values do in EvalPostOrder.
+Expr *OptimizeExpr(Expr *expr)
+{
+	PostOrder order = {0};
+	FlattenExpr(expr, &order);
+
+	Optimized *stack = malloc(order.maxStackDepth * sizeof(*stack));
+	assert(stack && "Out of memory");
+	size_t depth = 0;
+
+	for (size_t i = 0; i < order.count; ++i)
+	{
+		Expr *node = order.nodes[i];
+		Optimized result = {0};
+
+		if (node->type == EXPR_BINOP)
+		{
+			Optimized rhs = stack[--depth];
+			Optimized lhs = stack[--depth];
+
+			// The left hand side of an assignment is its variable, which
+			// stays as it is.
+			node->as.binop.lhs = lhs.expr;
+			node->as.binop.rhs = rhs.expr;
+
+			result.hasAssignment = lhs.hasAssignment || rhs.hasAssignment || node->as.binop.op == OP_ASSIGN;
+			result.expr = OptimizeNode(node, lhs.hasAssignment);
+		}
+		else
+		{
+			result.expr = OptimizeNode(node, false);
+		}
+
+		stack[depth++] = result;
+	}
+
+	assert(depth == 1);
+	expr = stack[0].expr;
+
+	free(stack);
+	PostOrderFree(&order);
+	return expr;
+}
+
+int CountExprNodes(Expr *expr)
+{
+	PostOrder order = {0};
+	FlattenExpr(expr, &order);
+	int count = (int)order.count;
+	PostOrderFree(&order);
+	return count;
+}
\ No newline at end of file
@@ -0,0 +1,21 @@
+#ifndef OPTIMIZE_H
+#define OPTIMIZE_H
+
+#include "parser.h"
+
+// Rewrites the tree in place so it does less work per evaluation, and
+// returns the new root, which may be one of the nodes below the old one:
+// - Subtrees without variables are folded to a number.
+// - Identities like x*1, x/1, x+0, x-0, x^1 and x^0 are removed, and
+//   multiplying or dividing by -1 becomes a negation.
+// - Negations are folded into numbers, cancelled in pairs across * and /,
+//   and turned into subtraction across + and -.
+// The result is the same as before, except that some identities hold for
+// real numbers but not for a zero's sign: x + 0 is -0 for x = -0, the
+// simplified x is not. Assignments are never removed or reordered.
+Expr *OptimizeExpr(Expr *expr);
+
+// Number of nodes in the tree.
+int CountExprNodes(Expr *expr);
+
+#endif
\ No newline at end of file
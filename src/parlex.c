@@ -0,0 +1,185 @@
+#include "parlex.h"
+#include "scan.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Chunks per thread, so a thread that finishes early can take another.
+#define PARLEX_CHUNKS_PER_THREAD 4
+
+typedef struct LexChunk_t
+{
+	const char *begin;
+	const char *end;
+	TokenBuffer tokens;
+	Scope scope; // Views into the input, interned in the stream's scope when stitched
+} LexChunk;
+
+typedef struct LexJob_t
+{
+	const char *start; // Of the stream, which offsets are counted from
+	LexChunk *chunks;
+} LexJob;
+
+static void LexChunkTask(void *context, size_t task)
+{
+	LexJob *job = context;
+	LexChunk *chunk = &job->chunks[task];
+
+	TokenStream ts = {
+		.start = job->start,
+		.at = chunk->begin,
+		.end = chunk->end,
+		.scope = &chunk->scope,
+		.identViews = true,
+	};
+	LexTokens(&ts, &chunk->tokens);
+}
+
+// Returns array with room for count elements.
+static void *Reserve(void *array, size_t *capacity, size_t count, size_t size)
+{
+	if (count <= *capacity) return array;
+
+	*capacity = count;
+	array = realloc(array, count * size);
+	assert(array && "Out of memory");
+	return array;
+}
+
+// Splits [at, end) into at most maxCount chunks of about the same size, each
+// but the last ending just after a newline. Returns the number of chunks.
+static size_t SplitAtNewlines(const char *at, const char *end, LexChunk *chunks, size_t maxCount)
+{
+	size_t chunkBytes = (size_t)(end - at) / maxCount + 1;
+	size_t count = 0;
+
+	while (at < end)
+	{
+		const char *split = end;
+
+		if (count + 1 < maxCount && (size_t)(end - at) > chunkBytes)
+		{
+			const char *newline = memchr(at + chunkBytes, '\n', (size_t)(end - at) - chunkBytes);
+			if (newline) split = newline + 1;
+		}
+
+		chunks[count++] = (LexChunk){.begin = at, .end = split};
+		at = split;
+	}
+
+	return count;
+}
+
+void LexTokensParallel(TokenStream *ts, TokenBuffer *buffer, ThreadPool *pool)
+{
+	size_t remaining = (size_t)(ts->end - ts->at);
+	size_t maxCount = (size_t)(pool->threadCount + 1) * PARLEX_CHUNKS_PER_THREAD;
+	if (maxCount > remaining / PARLEX_MIN_CHUNK_BYTES) maxCount = remaining / PARLEX_MIN_CHUNK_BYTES;
+
+	// Without workers, splitting would only add the cost of stitching.
+	if (maxCount < 2 || pool->threadCount == 0)
+	{
+		LexTokens(ts, buffer);
+		return;
+	}
+
+	LexChunk *chunks = malloc(maxCount * sizeof(*chunks));
+	assert(chunks && "Out of memory");
+
+	size_t chunkCount = SplitAtNewlines(ts->at, ts->end, chunks, maxCount);
+
+	// The kernels are picked on first use, which must not race.
+	ScanPrepare();
+
+	LexJob job = {.start = ts->start, .chunks = chunks};
+	PoolRun(pool, chunkCount, LexChunkTask, &job);
+
+	// A '\0' ends the input early, so the tokens end with the first chunk
+	// that stopped before its end.
+	size_t lastChunk = 0;
+	size_t tokenCount = 0;
+	size_t numberCount = 0;
+	size_t identCount = 0;
+
+	for (size_t i = 0; i < chunkCount; ++i)
+	{
+		LexChunk *chunk = &chunks[i];
+		PackedToken inputEnd = chunk->tokens.tokens[chunk->tokens.count - 1];
+
+		lastChunk = i;
+		tokenCount += chunk->tokens.count - 1;
+		numberCount += chunk->tokens.numberCount;
+		identCount += chunk->tokens.identCount;
+
+		if (ts->start + inputEnd.offset != chunk->end) break;
+	}
+
+	buffer->tokens = Reserve(buffer->tokens, &buffer->capacity, tokenCount + 1, sizeof(*buffer->tokens));
+	buffer->numbers = Reserve(buffer->numbers, &buffer->numberCapacity, numberCount, sizeof(*buffer->numbers));
+	buffer->idents = Reserve(buffer->idents, &buffer->identCapacity, identCount, sizeof(*buffer->idents));
+
+	buffer->count = 0;
+	buffer->numberCount = 0;
+	buffer->identCount = 0;
+	buffer->start = ts->start;
+
+	Symbol *symbols = NULL;
+	size_t symbolCapacity = 0;
+
+	for (size_t i = 0; i <= lastChunk; ++i)
+	{
+		LexChunk *chunk = &chunks[i];
+
+		// Only the input end of the last chunk is kept.
+		size_t count = chunk->tokens.count - (i < lastChunk);
+		memcpy(buffer->tokens + buffer->count, chunk->tokens.tokens, count * sizeof(*buffer->tokens));
+		buffer->count += count;
+
+		memcpy(buffer->numbers + buffer->numberCount, chunk->tokens.numbers, chunk->tokens.numberCount * sizeof(*buffer->numbers));
+		buffer->numberCount += chunk->tokens.numberCount;
+
+		// Names in a chunk's scope are in the order they first appear, so
+		// interning them chunk by chunk numbers them as one pass would.
+		if (chunk->scope.count)
+		{
+			assert(ts->scope && "Identifiers need a scope to be interned in");
+			symbols = Reserve(symbols, &symbolCapacity, (size_t)chunk->scope.count, sizeof(*symbols));
+
+			for (int local = 0; local < chunk->scope.count; ++local)
+			{
+				Ident name = chunk->scope.names[local];
+				symbols[local] = ts->identViews
+					? ScopeSlotView(ts->scope, name.chars, name.len)
+					: ScopeSlot(ts->scope, name.chars, name.len);
+			}
+		}
+
+		for (size_t j = 0; j < chunk->tokens.identCount; ++j)
+		{
+			buffer->idents[buffer->identCount++] = symbols[chunk->tokens.idents[j]];
+		}
+	}
+
+	ts->at = ts->start + buffer->tokens[buffer->count - 1].offset;
+
+	free(symbols);
+	for (size_t i = 0; i < chunkCount; ++i)
+	{
+		TokenBufferFree(&chunks[i].tokens);
+		ScopeFree(&chunks[i].scope);
+	}
+	free(chunks);
+}
+
+void ParserInitParallel(Parser *parser, TokenStream *ts, ThreadPool *pool)
+{
+	*parser = (Parser){0};
+
+	Scope *previousScope = ts->scope;
+	ts->scope = &parser->scope;
+	LexTokensParallel(ts, &parser->tokens, pool);
+	ts->scope = previousScope;
+}
\ No newline at end of file
@@ -0,0 +1,29 @@
+#ifndef PARLEX_H
+#define PARLEX_H
+
+#include "parser.h"
+#include "pool.h"
+#include "tokenizer.h"
+
+// Parallel lexing of large inputs. The rest of the stream is split into
+// chunks just after newlines, which no token spans, and each chunk is
+// lexed on a thread of the pool with a scope of its own. The chunks are
+// then stitched in order, interning their names in the stream's scope, so
+// the buffer, the symbols and the scope come out the same as from
+// LexTokens. Offsets are from the start of the stream either way, so
+// locations need no correction.
+
+// Inputs are not split into chunks smaller than this.
+#define PARLEX_MIN_CHUNK_BYTES (1 << 18)
+
+// Inputs smaller than this are not worth starting threads for; they would
+// not be split.
+#define PARLEX_MIN_INPUT_BYTES (2*PARLEX_MIN_CHUNK_BYTES)
+
+// Same as LexTokens, on the threads of pool.
+void LexTokensParallel(TokenStream *ts, TokenBuffer *buffer, ThreadPool *pool);
+
+// Same as ParserInit, lexing with LexTokensParallel.
+void ParserInitParallel(Parser *parser, TokenStream *ts, ThreadPool *pool);
+
+#endif
\ No newline at end of file
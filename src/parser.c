@@ -21,6 +21,7 @@ static void OperatorPrecedence(int op, int *lPrec, int *rPrec)
 		case '*': p = 0x200; break;
 		case '/': p = 0x200; break;
 		case '^': p = 0x300; r = 1; break;
+		case '=': p = 0x080; r = 1; break;
 		default:
 			assert(0 && "Invalid code path!");
 	}
@@ -29,7 +30,14 @@ static void OperatorPrecedence(int op, int *lPrec, int *rPrec)
 	*rPrec = 2*p + (1 & (1 - r));
 }
 
-static Expr *ErrorExpr(int lineNumber, int characterColumn, const char *restrict messageFormat, ...)
+static Expr *NewExpr(Parser *parser, ExprType type)
+{
+	Expr *result = ArenaAlloc(&parser->arena, sizeof(*result));
+	result->type = type;
+	return result;
+}
+
+static Expr *ErrorExpr(Parser *parser, const PackedToken *at, const char *restrict messageFormat, ...)
 {
 	char messageBuffer[512];
 
@@ -40,281 +48,582 @@ static Expr *ErrorExpr(int lineNumber, int characterColumn, const char *restrict
 
 	assert(messageLen >= 0 && messageLen < (int)sizeof(messageBuffer));
 
-	char *message = malloc(messageLen + 1);
-	strncpy(message, messageBuffer, messageLen);
+	char *message = ArenaStrndup(&parser->arena, messageBuffer, messageLen);
 
-	Expr *result = calloc(1, sizeof(*result));
-	result->type = EXPR_PARSE_ERROR;
-	result->as.error = (ParseError){
-	    .message = message,
-	    .line = lineNumber,
-	    .column = characterColumn,
-	};
+	Expr *result = NewExpr(parser, EXPR_PARSE_ERROR);
+	result->as.error.message = message;
+	TokenBufferLocation(&parser->tokens, at->offset, &result->as.error.line, &result->as.error.column);
 	return result;
 }
 
-Expr *ParseExpression(TokenStream *ts, int minimumPrecedence, Token stopToken)
+void ParserInit(Parser *parser, TokenStream *ts)
 {
-	bool negate = false;
-	Token token;
-
-	//
-	// Parse LValue
-	//
-restart:
- 	token = NextToken(ts);
-	Expr *lhs;
-
-	if (token.type == TOK_IDENT) {
-		lhs = calloc(1, sizeof(*lhs));
-		lhs->type = EXPR_VARIABLE;
-		lhs->as.variable = (VariableExpr){.ident = token.as.ident};
-	}
-	else if (token.type == TOK_NUMBER)
-	{
-		lhs = calloc(1, sizeof(*lhs));
-		lhs->type = EXPR_NUMBER;
-		lhs->as.number = token.as.number;
-	}
-	else if (token.type == '(')
-	{
-		lhs = ParseExpression(ts, 0, (Token){.type = ')'});
+	*parser = (Parser){0};
+	ParserReset(parser, ts);
+}
 
-		Token endParen = NextToken(ts);
-		if (endParen.type != ')')
-		{
-			return ErrorExpr(
-				endParen.line, endParen.column,
-				"Expected token ')', found: %d '%c'",
-				endParen.type, endParen.type);
-		}
-	}
-	else if (token.type == '-') // Unary minus
-	{
-		negate = !negate;
-		goto restart;
-	}
-	else if (token.type == TOK_INPUT_END)
-	{
-		return NULL;
-	}
-	else
+void ParserReset(Parser *parser, TokenStream *ts)
+{
+	ArenaReset(&parser->arena);
+	parser->at = 0;
+	parser->numberAt = 0;
+	parser->identAt = 0;
+	parser->refill = NULL;
+	parser->refillContext = NULL;
+
+	Scope *previousScope = ts->scope;
+	ts->scope = &parser->scope;
+	LexTokens(ts, &parser->tokens);
+	ts->scope = previousScope;
+}
+
+void ParserResetStreaming(Parser *parser, ParserRefillFn *refill, void *context)
+{
+	ArenaReset(&parser->arena);
+	parser->at = 0;
+	parser->numberAt = 0;
+	parser->identAt = 0;
+	parser->refill = refill;
+	parser->refillContext = context;
+
+	// Empty, so the first token comes from refill.
+	parser->tokens.count = 0;
+}
+
+void ParserRelease(Parser *parser)
+{
+	TokenBufferFree(&parser->tokens);
+	ArenaRelease(&parser->arena);
+	ScopeFree(&parser->scope);
+	free(parser->frames);
+	parser->frames = NULL;
+	parser->frameCapacity = 0;
+	parser->at = 0;
+	parser->numberAt = 0;
+	parser->identAt = 0;
+	parser->refill = NULL;
+	parser->refillContext = NULL;
+}
+
+static PackedToken *PeekToken(Parser *parser)
+{
+	// Only a streaming parser runs out of tokens, as the input end is never
+	// taken. Tokens from before a refill are not used afterwards.
+	if (parser->at == parser->tokens.count)
 	{
-		return ErrorExpr(
-			token.line, token.column,
-			"Unexpected token: %d '%c'",
-			token.type, token.type);
+		assert(parser->refill && "Tokens end without TOK_INPUT_END");
+		parser->refill(parser->refillContext, &parser->tokens);
+		assert(parser->tokens.count > 0);
+		parser->at = 0;
+		parser->numberAt = 0;
+		parser->identAt = 0;
 	}
 
-	if (negate)
+	return &parser->tokens.tokens[parser->at];
+}
+
+// The values of numbers and identifiers are read from the side arrays of the
+// buffer by whoever takes the token, which advances numberAt or identAt.
+static PackedToken *TakeToken(Parser *parser)
+{
+	PackedToken *token = PeekToken(parser);
+
+	// The input always ends with TOK_INPUT_END, which is never consumed.
+	if (token->type != TOK_INPUT_END) ++parser->at;
+
+	return token;
+}
+
+static void PushFrame(Parser *parser, size_t *depth, ParseFrame frame)
+{
+	if (*depth == parser->frameCapacity)
 	{
-		// XOR to toggle the negation of the left hand side expressoin
-		lhs->flags ^= EXPR_FLAG_NEGATED;
+		parser->frameCapacity = parser->frameCapacity ? 2*parser->frameCapacity : 64;
+		parser->frames = realloc(parser->frames, parser->frameCapacity * sizeof(*parser->frames));
+		assert(parser->frames && "Out of memory");
 	}
 
-	//
-	// Parse RValue
-	//
-	for (;;)
-	{
-		TokenStream tsTemp = *ts;
-		Token tokOp = NextToken(&tsTemp);
+	parser->frames[(*depth)++] = frame;
+}
 
-		if (tokOp.type == stopToken.type)
-			return lhs;
+Expr *ParseExpression(Parser *parser, int minimumPrecedence, Token stopToken)
+{
+	// Precedence climbing without recursion: where a right hand side or a
+	// parenthesis would be parsed by a nested call, a frame is pushed, and
+	// it is popped where that call would have returned.
+	size_t depth = 0;
+	size_t openParens = 0;
 
-		switch (tokOp.type)
+	for (;;)
+	{
+		bool negate = false;
+		PackedToken *token;
+		Expr *lhs;
+
+		//
+		// Parse LValue
+		//
+		for (;;)
 		{
-		case '=': {
-			if (lhs->type != EXPR_VARIABLE) {
-				return ErrorExpr(tokOp.line, tokOp.column, "Left-hand side of operator '=' must be a variable");
-			}
-		} break;
-
-		case '+':
-		case '-':
-		case '*':
-		case '/':
-		case '^':
-			break;
+			token = TakeToken(parser);
 
-		default:
-			if (tokOp.type == TOK_IDENT) {
-				return ErrorExpr(
-				    tokOp.line, tokOp.column,
-				    "Unexpected identifier, '%.*s'",
-				    tokOp.as.ident.len, tokOp.as.ident.chars);
+			if (token->type == '-') // Unary minus
+			{
+				negate = !negate;
 			}
-			else {
-				return ErrorExpr(
-					tokOp.line, tokOp.column,
-					"Unexpected token: %d '%c'",
-					tokOp.type, tokOp.type);
+			else if (token->type == '(')
+			{
+				PushFrame(parser, &depth, (ParseFrame){
+					.op = '(',
+					.minimumPrecedence = minimumPrecedence,
+					.negate = negate,
+				});
+				++openParens;
+				minimumPrecedence = 0;
+				negate = false;
 			}
+			else break;
 		}
 
-		int lPrec, rPrec;
-		OperatorPrecedence(tokOp.type, &lPrec, &rPrec);
-
-		if (lPrec < minimumPrecedence)
+		if (token->type == TOK_IDENT) {
+			Symbol symbol = parser->tokens.idents[parser->identAt++];
+			lhs = NewExpr(parser, EXPR_VARIABLE);
+			lhs->as.variable = (VariableExpr){
+				.ident = parser->scope.names[symbol],
+				.slot = symbol,
+			};
+		}
+		else if (token->type == TOK_NUMBER)
 		{
-			break;
+			lhs = NewExpr(parser, EXPR_NUMBER);
+			lhs->as.number = parser->tokens.numbers[parser->numberAt++];
 		}
+		else if (token->type == TOK_INPUT_END)
+		{
+			if (depth == 0) return NULL;
 
-		ts->at = tsTemp.at;
-		Expr *rhs = ParseExpression(ts, rPrec, stopToken);
+			ParseFrame *top = &parser->frames[depth - 1];
+			if (top->lhs)
+			{
+				return ErrorExpr(parser, token,
+					"Operator '%c' missing right hand operand",
+					top->op);
+			}
 
-		if (rhs == NULL)
+			return ErrorExpr(parser, token,
+				"Expected token ')', found: %d '%c'",
+				token->type, token->type);
+		}
+		else
 		{
-			return ErrorExpr(
-				ts->lineCount, GetColumn(ts),
-				"Operator '%c' missing right hand operand",
-				tokOp.type);
+			return ErrorExpr(parser, token,
+				"Unexpected token: %d '%c'",
+				token->type, token->type);
 		}
-		else if (rhs->type == EXPR_PARSE_ERROR)
+
+		if (negate)
 		{
-			return rhs;
+			// XOR to toggle the negation of the left hand side expressoin
+			lhs->flags ^= EXPR_FLAG_NEGATED;
 		}
 
-		Expr *newLhs = calloc(1, sizeof(*newLhs));
-		newLhs->type = EXPR_BINOP;
-		newLhs->as.binop = (BinNode)
+		//
+		// Parse RValue
+		//
+		PackedToken *tokOp;
+		int lPrec, rPrec;
+
+		for (;;)
 		{
-			.op = tokOp.type,
+			tokOp = PeekToken(parser);
+
+			bool done = tokOp->type == (openParens ? ')' : stopToken.type);
+
+			if (!done)
+			{
+				switch (tokOp->type)
+				{
+				case '=': {
+					if (lhs->type != EXPR_VARIABLE || (lhs->flags & EXPR_FLAG_NEGATED)) {
+						return ErrorExpr(parser, tokOp, "Left-hand side of operator '=' must be a variable");
+					}
+				} break;
+
+				case '+':
+				case '-':
+				case '*':
+				case '/':
+				case '^':
+					break;
+
+				default:
+					if (openParens) {
+						return ErrorExpr(parser, tokOp,
+							"Expected token ')', found: %d '%c'",
+							tokOp->type, tokOp->type);
+					}
+					else if (tokOp->type == TOK_IDENT) {
+						Ident name = parser->scope.names[parser->tokens.idents[parser->identAt]];
+						return ErrorExpr(parser, tokOp,
+						    "Unexpected identifier, '%.*s'",
+						    (int)name.len, name.chars);
+					}
+					else {
+						return ErrorExpr(parser, tokOp,
+							"Unexpected token: %d '%c'",
+							tokOp->type, tokOp->type);
+					}
+				}
+
+				OperatorPrecedence(tokOp->type, &lPrec, &rPrec);
+				done = lPrec < minimumPrecedence;
+			}
+
+			if (!done) break;
+
+			// lhs is complete; hand it to the innermost waiting frame.
+			if (depth == 0) return lhs;
+
+			ParseFrame top = parser->frames[--depth];
+			minimumPrecedence = top.minimumPrecedence;
+
+			if (top.lhs)
+			{
+				Expr *newLhs = NewExpr(parser, EXPR_BINOP);
+				newLhs->as.binop = (BinNode)
+				{
+					.op = top.op,
+					.lhs = top.lhs,
+					.rhs = lhs,
+				};
+
+				lhs = newLhs;
+			}
+			else
+			{
+				// Only ')' ends the level a parenthesis opened.
+				assert(tokOp->type == ')');
+				TakeToken(parser);
+				--openParens;
+
+				if (top.negate) lhs->flags ^= EXPR_FLAG_NEGATED;
+			}
+		}
+
+		TakeToken(parser);
+		PushFrame(parser, &depth, (ParseFrame){
 			.lhs = lhs,
-			.rhs = rhs,
-		};
+			.op = tokOp->type,
+			.minimumPrecedence = minimumPrecedence,
+		});
+		minimumPrecedence = rPrec;
+	}
+}
+
+bool ExprConstantHalves(const Expr *exponent, int *halves)
+{
+	if (exponent->type != EXPR_NUMBER) return false;
+
+	double twice = 2 * exponent->as.number;
+	if (exponent->flags & EXPR_FLAG_NEGATED) twice = -twice;
+
+	// Also false for NaN.
+	if (!(fabs(twice) <= POW_HALVES_MAX) || twice != floor(twice)) return false;
+
+	*halves = (int)twice;
+	return true;
+}
+
+double PowHalves(double base, int halves)
+{
+	unsigned n = halves < 0 ? -(unsigned)halves : (unsigned)halves;
+	unsigned whole = n >> 1;
+	double result = 1;
+
+	if (whole)
+	{
+		unsigned bit = 1;
+		while (bit <= whole >> 1) bit <<= 1;
 
-		lhs = newLhs;
+		result = base;
+		for (bit >>= 1; bit; bit >>= 1)
+		{
+			result *= result;
+			if (whole & bit) result *= base;
+		}
 	}
 
-	return lhs;
+	if (n & 1) result = whole ? result * sqrt(base) : sqrt(base);
+	if (halves < 0) result = 1 / result;
+
+	return result;
 }
 
-double EvalExpr(Expr *expr)
+void FlattenExpr(Expr *expr, PostOrder *order)
 {
-	double result = 0;
+	order->count = 0;
+	order->maxStackDepth = 0;
+
+	// Taking nodes root first and pushing the left operand before the right
+	// yields post order reversed.
+	size_t pendingCount = 0;
+	Expr *node = expr;
 
-	switch (expr->type)
+	for (;;)
 	{
-		case EXPR_NUMBER:
+		if (order->count == order->capacity)
 		{
-			result = expr->as.number;
-		} break;
+			order->capacity = order->capacity ? 2*order->capacity : 64;
+			order->nodes = realloc(order->nodes, order->capacity * sizeof(*order->nodes));
+			assert(order->nodes && "Out of memory");
+		}
+		order->nodes[order->count++] = node;
 
-		case EXPR_BINOP:
+		if (node->type == EXPR_BINOP)
 		{
-			BinNode bn = expr->as.binop;
-			double lresult = EvalExpr(bn.lhs);
-			double rresult = EvalExpr(bn.rhs);
-			switch (bn.op)
+			if (pendingCount + 2 > order->pendingCapacity)
 			{
-				case '+': result = lresult + rresult; break;
-				case '-': result = lresult - rresult; break;
-				case '*': result = lresult * rresult; break;
-				case '/': result = lresult / rresult; break;
-				case '^': result = pow(lresult, rresult); break;
-				default:
-					return 42.0;
+				order->pendingCapacity = order->pendingCapacity ? 2*order->pendingCapacity : 64;
+				order->pending = realloc(order->pending, order->pendingCapacity * sizeof(*order->pending));
+				assert(order->pending && "Out of memory");
 			}
-		} break;
-
-		case EXPR_PARSE_ERROR:
-		{
-			assert(!"TODO: eval parse error");
-		} break;
+			order->pending[pendingCount++] = node->as.binop.lhs;
+			order->pending[pendingCount++] = node->as.binop.rhs;
+		}
 
-		default:
-			assert(0 && "Invalid code path!");
+		if (pendingCount == 0) break;
+		node = order->pending[--pendingCount];
 	}
 
-	if (expr->flags & EXPR_FLAG_NEGATED)
+	int depth = 0;
+	for (size_t i = 0, j = order->count - 1; i < j; ++i, --j)
 	{
-		result = -result;
+		Expr *swap = order->nodes[i];
+		order->nodes[i] = order->nodes[j];
+		order->nodes[j] = swap;
 	}
+	for (size_t i = 0; i < order->count; ++i)
+	{
+		depth += order->nodes[i]->type == EXPR_BINOP ? -1 : +1;
+		if (depth > order->maxStackDepth) order->maxStackDepth = depth;
+	}
+}
 
-	return result;
+void PostOrderFree(PostOrder *order)
+{
+	free(order->nodes);
+	free(order->pending);
+	*order = (PostOrder){0};
 }
 
-void PrintExprInfix(Expr *expr)
+double EvalPostOrder(const PostOrder *order, double *variables)
 {
-	if (!expr) return;
+	double localStack[64];
+	double *stack = localStack;
+
+	if (order->maxStackDepth > (int)(sizeof(localStack)/sizeof(*localStack)))
+	{
+		stack = malloc(order->maxStackDepth * sizeof(*stack));
+		assert(stack && "Out of memory");
+	}
 
-	bool negated = false;
-	if (expr->flags & EXPR_FLAG_NEGATED) negated = true;
+	// sp points at the top of the stack, one below the first free slot.
+	double *sp = stack - 1;
 
-	switch (expr->type) {
-	case EXPR_NUMBER:
-		if (negated) printf("-");
-		printf("%g", expr->as.number);
-		break;
+	for (size_t i = 0; i < order->count; ++i)
+	{
+		Expr *expr = order->nodes[i];
+		double result = 0;
 
-	case EXPR_BINOP:
-		if (negated) printf("-");
-		printf("(");
-		PrintExprInfix(expr->as.binop.lhs);
-		printf(" %c ", expr->as.binop.op);
-		PrintExprInfix(expr->as.binop.rhs);
-		printf(")");
-		break;
+		switch (expr->type)
+		{
+			case EXPR_NUMBER:
+			{
+				result = expr->as.number;
+			} break;
 
-	case EXPR_PARSE_ERROR:
-		assert(!"TODO: print parse error");
-		break;
+			case EXPR_VARIABLE:
+			{
+				result = variables[expr->as.variable.slot];
+			} break;
+
+			case EXPR_BINOP:
+			{
+				BinNode bn = expr->as.binop;
+				double rresult = *sp--;
+				double lresult = *sp--;
+
+				switch (bn.op)
+				{
+					case '+': result = lresult + rresult; break;
+					case '-': result = lresult - rresult; break;
+					case '*': result = lresult * rresult; break;
+					case '/': result = lresult / rresult; break;
+					case '^':
+					{
+						int halves;
+						if (ExprConstantHalves(bn.rhs, &halves)) result = PowHalves(lresult, halves);
+						else result = pow(lresult, rresult);
+					} break;
+					case '=':
+					{
+						// The variable was read as the left operand; only the slot matters.
+						result = rresult;
+						variables[bn.lhs->as.variable.slot] = result;
+					} break;
+					default:
+						result = 42.0;
+				}
+			} break;
+
+			case EXPR_PARSE_ERROR:
+			{
+				assert(!"TODO: eval parse error");
+			} break;
+
+			default:
+				assert(0 && "Invalid code path!");
+		}
+
+		if (expr->flags & EXPR_FLAG_NEGATED)
+		{
+			result = -result;
+		}
+
+		*++sp = result;
 	}
+
+	assert(sp == stack);
+	double result = *sp;
+
+	if (stack != localStack) free(stack);
+
+	return result;
 }
 
-void PrintExprRpn(Expr *expr)
+double EvalExpr(Expr *expr, double *variables)
+{
+	PostOrder order = {0};
+	FlattenExpr(expr, &order);
+	double result = EvalPostOrder(&order, variables);
+	PostOrderFree(&order);
+	return result;
+}
+
+typedef enum
+{
+	PRINT_STYLE_INFIX,
+	PRINT_STYLE_RPN,
+	PRINT_STYLE_S,
+} PrintStyle;
+
+static void PrintLeaf(Expr *expr)
 {
-	bool negated = false;
-	if (expr->flags & EXPR_FLAG_NEGATED) negated = true;
+	if (expr->flags & EXPR_FLAG_NEGATED) printf("-");
 
 	switch (expr->type) {
 	case EXPR_NUMBER:
-		if (negated) printf("-");
 		printf("%g", expr->as.number);
 		break;
 
-	case EXPR_BINOP:
-		if (negated) printf("-");
-		PrintExprRpn(expr->as.binop.lhs);
-		printf(" ");
-		PrintExprRpn(expr->as.binop.rhs);
-		printf(" %c", expr->as.binop.op);
+	case EXPR_VARIABLE:
+		printf("%.*s", (int)expr->as.variable.ident.len, expr->as.variable.ident.chars);
 		break;
 
-	case EXPR_PARSE_ERROR:
+	default:
 		assert(!"TODO: print parse error");
 		break;
 	}
 }
 
-void PrintExprS(Expr *expr)
+// Walks the tree with its own stack; each operator is visited before its
+// left operand, between its operands and after its right operand.
+static void PrintExpr(Expr *expr, PrintStyle style)
 {
-	bool negated = false;
-	if (expr->flags & EXPR_FLAG_NEGATED) negated = true;
+	if (!expr) return;
+
+	typedef struct { Expr *expr; int visits; } PrintFrame;
 
-	switch (expr->type)
+	PrintFrame localStack[64];
+	PrintFrame *stack = localStack;
+	size_t capacity = sizeof(localStack)/sizeof(*localStack);
+	size_t depth = 0;
+
+	stack[depth++] = (PrintFrame){expr, 0};
+
+	while (depth)
 	{
-		case EXPR_NUMBER:
+		PrintFrame *top = &stack[depth - 1];
+		Expr *node = top->expr;
+
+		if (node->type != EXPR_BINOP)
 		{
-			if (negated) printf("-");
-			printf("%g", expr->as.number);
-		} break;
+			PrintLeaf(node);
+			--depth;
+			continue;
+		}
+
+		bool negated = node->flags & EXPR_FLAG_NEGATED;
+		char op = node->as.binop.op;
+		Expr *next = NULL;
 
-		case EXPR_BINOP:
+		switch (top->visits++)
 		{
-			printf("(%c ", expr->as.binop.op);
-			if (negated) printf("-");
-			PrintExprS(expr->as.binop.lhs);
-			printf(" ");
-			PrintExprS(expr->as.binop.rhs);
-			printf(")");
-		} break;
-
-		case EXPR_PARSE_ERROR:
+		case 0:
+			if (style == PRINT_STYLE_INFIX) printf(negated ? "-(" : "(");
+			else if (style == PRINT_STYLE_S) printf(negated ? "(%c -" : "(%c ", op);
+			else if (negated) printf("-");
+			next = node->as.binop.lhs;
+			break;
+
+		case 1:
+			if (style == PRINT_STYLE_INFIX) printf(" %c ", op);
+			else printf(" ");
+			next = node->as.binop.rhs;
+			break;
+
+		default:
+			if (style == PRINT_STYLE_RPN) printf(" %c", op);
+			else printf(")");
+			--depth;
+			break;
+		}
+
+		if (next)
 		{
-			assert(!"TODO: print parse error");
-		} break;
+			if (depth == capacity)
+			{
+				capacity *= 2;
+				if (stack == localStack)
+				{
+					stack = malloc(capacity * sizeof(*stack));
+					assert(stack && "Out of memory");
+					memcpy(stack, localStack, sizeof(localStack));
+				}
+				else
+				{
+					stack = realloc(stack, capacity * sizeof(*stack));
+					assert(stack && "Out of memory");
+				}
+			}
+			stack[depth++] = (PrintFrame){next, 0};
+		}
 	}
+
+	if (stack != localStack) free(stack);
+}
+
+void PrintExprInfix(Expr *expr)
+{
+	PrintExpr(expr, PRINT_STYLE_INFIX);
+}
+
+void PrintExprRpn(Expr *expr)
+{
+	PrintExpr(expr, PRINT_STYLE_RPN);
+}
+
+void PrintExprS(Expr *expr)
+{
+	PrintExpr(expr, PRINT_STYLE_S);
 }
\ No newline at end of file
@@ -1,6 +1,9 @@
 #ifndef PARSER_H
 #define PARSER_H
 
+#include <stdbool.h>
+
+#include "arena.h"
 #include "tokenizer.h"
 
 typedef enum
@@ -10,6 +13,7 @@ typedef enum
 	OP_MULTIPLY = '*',
 	OP_DIVIDE = '/',
 	OP_EXP = '^',
+	OP_ASSIGN = '=',
 } Operator;
 
 typedef struct Expr_t Expr;
@@ -29,7 +33,8 @@ typedef struct ParseError_t
 } ParseError;
 
 typedef struct VariableExpr {
-	Ident ident;
+	Ident ident; // Interned in the parser's scope
+	int slot; // Index into the variable values the expression is evaluated with
 } VariableExpr;
 
 typedef enum
@@ -59,10 +64,94 @@ struct Expr_t
 	} as;
 };
 
+// An operator waiting for its right hand side, or an open parenthesis
+// waiting for its ')'. ParseExpression keeps these on its own stack instead
+// of recursing, so nesting is only limited by memory.
+typedef struct ParseFrame_t
+{
+	Expr *lhs; // Left operand of op, NULL for a parenthesis
+	int op; // '(' for a parenthesis
+	int minimumPrecedence; // Of the enclosing level, restored on pop
+	bool negate; // Negation in front of the parenthesis
+} ParseFrame;
+
+// Replaces *tokens with the next tokens of the input, once the parser has
+// used up the ones it had without reaching TOK_INPUT_END.
+typedef void ParserRefillFn(void *context, TokenBuffer *tokens);
+
+typedef struct Parser_t
+{
+	TokenBuffer tokens;
+	size_t at; // Index of the next token in tokens
+	size_t numberAt; // Index of the value of the next number in tokens.numbers
+	size_t identAt; // Index of the symbol of the next identifier in tokens.idents
+	Arena arena; // Owns every node, identifier and error message of the parse
+	Scope scope; // Identifiers, whose symbols are the variable slots; kept across ParserReset
+	ParseFrame *frames; // Stack of ParseExpression, kept across ParserReset
+	size_t frameCapacity;
+
+	ParserRefillFn *refill; // NULL if tokens holds the whole input
+	void *refillContext;
+} Parser;
+
+// Lexes the rest of the token stream up front; the parser then only walks
+// the token buffer.
+void ParserInit(Parser *parser, TokenStream *ts);
+
+// Starts over on a new input, reusing the memory of the previous parse.
+// Expressions from the previous parse are no longer valid afterwards.
+void ParserReset(Parser *parser, TokenStream *ts);
+
+// Starts over like ParserReset, but takes the tokens from refill a part at a
+// time, as they are needed. Identifiers in the tokens have to be symbols of
+// the parser's scope already.
+void ParserResetStreaming(Parser *parser, ParserRefillFn *refill, void *context);
+
+// Frees everything the parser has allocated, all expressions included.
+void ParserRelease(Parser *parser);
+
+Expr *ParseExpression(Parser *parser, int minPrec, Token stopToken);
+
+// The nodes of a tree in post order: both operands of an operator come
+// before it, so a single pass with a stack of values evaluates the tree,
+// however deep it is.
+typedef struct PostOrder_t
+{
+	Expr **nodes;
+	size_t count;
+	size_t capacity;
+	int maxStackDepth; // Values on the stack at most during evaluation
+
+	Expr **pending; // Scratch stack of FlattenExpr
+	size_t pendingCapacity;
+} PostOrder;
+
+// Replaces the contents of order with the nodes of expr, reusing its memory.
+void FlattenExpr(Expr *expr, PostOrder *order);
+void PostOrderFree(PostOrder *order);
+
+// variables holds the value of each slot of the parser's scope. Assignments
+// write to it.
+double EvalPostOrder(const PostOrder *order, double *variables);
+
+// Flattens and evaluates; for repeated evaluation, flatten once and use
+// EvalPostOrder.
+double EvalExpr(Expr *expr, double *variables);
+
+// Constant exponents that are a multiple of 1/2, up to this many halves
+// either way, are computed with multiplications and at most one sqrt
+// instead of pow. Every engine does it the same way, so they agree on the
+// result, which can be off from pow by a few ulps for larger exponents.
+#define POW_HALVES_MAX 64
 
-Expr *ParseExpression(TokenStream *ts, int minPrec, Token stopToken);
+// Returns true if exponent is a number that can be strength reduced, and
+// sets *halves to twice its value.
+bool ExprConstantHalves(const Expr *exponent, int *halves);
 
-double EvalExpr(Expr *expr);
+// base^(halves/2): squares and multiplies from the highest bit of the whole
+// part down, multiplies by sqrt(base) for an odd number of halves, and
+// takes the reciprocal last for a negative exponent.
+double PowHalves(double base, int halves);
 
 void PrintExprInfix(Expr *expr);
 void PrintExprRpn(Expr *expr);
@@ -0,0 +1,156 @@
+#include "pipeline.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static double Now(void)
+{
+	struct timespec now;
+	timespec_get(&now, TIME_UTC);
+	return (double)now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+static bool RingFull(Pipeline *pipeline, size_t head)
+{
+	return head - atomic_load_explicit(&pipeline->tail, memory_order_acquire) == PIPELINE_RING_BATCHES;
+}
+
+static int LexerThread(void *argument)
+{
+	Pipeline *pipeline = argument;
+	size_t head = 0;
+	int handedNames = 0; // Names of the lexer's scope in earlier batches
+	bool ended = false;
+
+	while (!ended)
+	{
+		if (RingFull(pipeline, head))
+		{
+			++pipeline->stats.lexerWaits;
+			while (RingFull(pipeline, head) && !atomic_load_explicit(&pipeline->stop, memory_order_relaxed)) thrd_yield();
+		}
+
+		if (atomic_load_explicit(&pipeline->stop, memory_order_relaxed)) break;
+
+		double start = Now();
+		TokenBatch *batch = &pipeline->batches[head % PIPELINE_RING_BATCHES];
+		ended = LexTokenBatch(pipeline->ts, &batch->tokens, PIPELINE_BATCH_TOKENS);
+
+		Scope *scope = &pipeline->lexerScope;
+		batch->nameCount = scope->count - handedNames;
+
+		if (batch->nameCount > batch->nameCapacity)
+		{
+			batch->nameCapacity = batch->nameCount;
+			batch->names = realloc(batch->names, batch->nameCapacity * sizeof(*batch->names));
+			assert(batch->names && "Out of memory");
+		}
+
+		memcpy(batch->names, scope->names + handedNames, batch->nameCount * sizeof(*batch->names));
+		handedNames = scope->count;
+
+		pipeline->stats.tokens += batch->tokens.count;
+		++pipeline->stats.batches;
+		pipeline->stats.lexSeconds += Now() - start;
+
+		atomic_store_explicit(&pipeline->head, ++head, memory_order_release);
+	}
+
+	return 0;
+}
+
+// The refill of the parser, on the parser's thread.
+static void TakeBatch(void *context, TokenBuffer *tokens)
+{
+	Pipeline *pipeline = context;
+	size_t tail = atomic_load_explicit(&pipeline->tail, memory_order_relaxed);
+
+	if (atomic_load_explicit(&pipeline->head, memory_order_acquire) == tail)
+	{
+		++pipeline->stats.parserWaits;
+		double start = Now();
+		while (atomic_load_explicit(&pipeline->head, memory_order_acquire) == tail) thrd_yield();
+		pipeline->stats.waitSeconds += Now() - start;
+	}
+
+	TokenBatch *batch = &pipeline->batches[tail % PIPELINE_RING_BATCHES];
+
+	if (pipeline->symbolCount + batch->nameCount > pipeline->symbolCapacity)
+	{
+		pipeline->symbolCapacity = 2*(pipeline->symbolCount + batch->nameCount);
+		pipeline->symbols = realloc(pipeline->symbols, pipeline->symbolCapacity * sizeof(*pipeline->symbols));
+		assert(pipeline->symbols && "Out of memory");
+	}
+
+	Scope *scope = &pipeline->parser->scope;
+	for (int i = 0; i < batch->nameCount; ++i)
+	{
+		Ident name = batch->names[i];
+		pipeline->symbols[pipeline->symbolCount++] = pipeline->identViews
+			? ScopeSlotView(scope, name.chars, name.len)
+			: ScopeSlot(scope, name.chars, name.len);
+	}
+
+	for (size_t i = 0; i < batch->tokens.identCount; ++i)
+	{
+		batch->tokens.idents[i] = pipeline->symbols[batch->tokens.idents[i]];
+	}
+
+	// The used up tokens go back into the ring, for the lexer to fill again.
+	TokenBuffer used = *tokens;
+	*tokens = batch->tokens;
+	batch->tokens = used;
+
+	atomic_store_explicit(&pipeline->tail, tail + 1, memory_order_release);
+}
+
+bool PipelineStart(Pipeline *pipeline, Parser *parser, TokenStream *ts)
+{
+	*pipeline = (Pipeline){
+		.ts = ts,
+		.previousScope = ts->scope,
+		.identViews = ts->identViews,
+		.parser = parser,
+	};
+	atomic_init(&pipeline->head, 0);
+	atomic_init(&pipeline->tail, 0);
+	atomic_init(&pipeline->stop, false);
+
+	// The lexer's names only have to last until the parser has interned
+	// them, and the input outlives the pipeline.
+	ts->scope = &pipeline->lexerScope;
+	ts->identViews = true;
+
+	if (thrd_create(&pipeline->thread, LexerThread, pipeline) != thrd_success)
+	{
+		ts->scope = pipeline->previousScope;
+		ts->identViews = pipeline->identViews;
+		return false;
+	}
+
+	ParserResetStreaming(parser, TakeBatch, pipeline);
+	return true;
+}
+
+void PipelineFinish(Pipeline *pipeline, PipelineStats *stats)
+{
+	atomic_store_explicit(&pipeline->stop, true, memory_order_relaxed);
+	thrd_join(pipeline->thread, NULL);
+
+	pipeline->ts->scope = pipeline->previousScope;
+	pipeline->ts->identViews = pipeline->identViews;
+	pipeline->parser->refill = NULL;
+	pipeline->parser->refillContext = NULL;
+
+	if (stats) *stats = pipeline->stats;
+
+	for (int i = 0; i < PIPELINE_RING_BATCHES; ++i)
+	{
+		TokenBufferFree(&pipeline->batches[i].tokens);
+		free(pipeline->batches[i].names);
+	}
+	ScopeFree(&pipeline->lexerScope);
+	free(pipeline->symbols);
+}
\ No newline at end of file
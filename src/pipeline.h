@@ -0,0 +1,75 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <threads.h>
+
+#include "parser.h"
+#include "tokenizer.h"
+
+// Lexing on a thread of its own while the parser takes the tokens. The
+// lexer fills batches of tokens in a ring; only it moves the head and only
+// the parser moves the tail, so handing over a batch is one atomic store,
+// and the parser swaps the batch in as its token buffer instead of copying
+// it. The lexer interns names in a scope of its own and the parser maps
+// them to symbols of its scope, so no scope is shared between the threads.
+
+#define PIPELINE_RING_BATCHES 8
+#define PIPELINE_BATCH_TOKENS 4096
+
+typedef struct TokenBatch_t
+{
+	TokenBuffer tokens; // Identifiers are symbols of the lexer's scope
+
+	// Names the lexer first saw in this batch, in the order of their symbols.
+	Ident *names;
+	int nameCount;
+	int nameCapacity;
+} TokenBatch;
+
+// Counters of the two sides of the ring; the more the lexing time is hidden
+// behind parsing, the fewer and shorter the waits of the parser.
+typedef struct PipelineStats_t
+{
+	size_t tokens;
+	size_t batches;
+	size_t lexerWaits;  // Batches the lexer had to wait for a free slot for
+	size_t parserWaits; // Batches the parser had to wait for
+	double lexSeconds;  // Spent lexing on the lexer thread, waits not included
+	double waitSeconds; // Spent waiting for tokens on the parser thread
+} PipelineStats;
+
+typedef struct Pipeline_t
+{
+	TokenBatch batches[PIPELINE_RING_BATCHES];
+	atomic_size_t head; // Batches handed over by the lexer
+	atomic_size_t tail; // Batches taken by the parser
+	atomic_bool stop;   // Set once the parse is done, maybe before the input end
+
+	thrd_t thread;
+	TokenStream *ts;
+	Scope *previousScope; // Of ts, given back by PipelineFinish
+	bool identViews;      // Of ts, for interning in the parser's scope
+	Scope lexerScope;
+
+	Parser *parser;
+	Symbol *symbols; // Symbol in the parser's scope of each lexer symbol
+	int symbolCount;
+	int symbolCapacity;
+
+	PipelineStats stats;
+} Pipeline;
+
+// Starts lexing ts on a new thread and resets parser to take the tokens as
+// they come; ParseExpression comes next. Leave ts and its input alone until
+// PipelineFinish. Returns false, with the parser untouched, if the thread
+// could not be started.
+bool PipelineStart(Pipeline *pipeline, Parser *parser, TokenStream *ts);
+
+// Stops the lexer thread and frees the ring, and fills in stats if it is
+// not NULL. The expressions and the scope of the parser stay valid.
+void PipelineFinish(Pipeline *pipeline, PipelineStats *stats);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,121 @@
+#include "pool.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+static void RunTasks(ThreadPool *pool, PoolTaskFn *fn, void *context, size_t taskCount)
+{
+	for (;;)
+	{
+		size_t task = atomic_fetch_add_explicit(&pool->nextTask, 1, memory_order_relaxed);
+		if (task >= taskCount) return;
+		fn(context, task);
+	}
+}
+
+static int Worker(void *argument)
+{
+	ThreadPool *pool = argument;
+	unsigned seenJob = 0;
+
+	mtx_lock(&pool->lock);
+
+	for (;;)
+	{
+		while (pool->job == seenJob && !pool->quit) cnd_wait(&pool->wake, &pool->lock);
+		if (pool->quit) break;
+
+		seenJob = pool->job;
+		PoolTaskFn *fn = pool->fn;
+		void *context = pool->context;
+		size_t taskCount = pool->taskCount;
+
+		mtx_unlock(&pool->lock);
+		RunTasks(pool, fn, context, taskCount);
+		mtx_lock(&pool->lock);
+
+		if (--pool->busyWorkers == 0) cnd_signal(&pool->done);
+	}
+
+	mtx_unlock(&pool->lock);
+	return 0;
+}
+
+bool PoolInit(ThreadPool *pool, int threadCount)
+{
+	*pool = (ThreadPool){0};
+	if (threadCount < 1) threadCount = 1;
+
+	if (mtx_init(&pool->lock, mtx_plain) != thrd_success) return false;
+	cnd_init(&pool->wake);
+	cnd_init(&pool->done);
+
+	pool->threads = calloc(threadCount, sizeof(*pool->threads));
+	if (!pool->threads)
+	{
+		PoolRelease(pool);
+		return false;
+	}
+
+	for (int i = 0; i < threadCount - 1; ++i)
+	{
+		if (thrd_create(&pool->threads[i], Worker, pool) != thrd_success)
+		{
+			PoolRelease(pool);
+			return false;
+		}
+		++pool->threadCount;
+	}
+
+	return true;
+}
+
+void PoolRun(ThreadPool *pool, size_t taskCount, PoolTaskFn *fn, void *context)
+{
+	if (pool->threadCount == 0 || taskCount == 1)
+	{
+		for (size_t task = 0; task < taskCount; ++task) fn(context, task);
+		return;
+	}
+
+	mtx_lock(&pool->lock);
+
+	// Workers still leaving the previous job would take tasks from this one
+	// with the old fn, so wait for all of them first.
+	while (pool->busyWorkers > 0) cnd_wait(&pool->done, &pool->lock);
+
+	pool->fn = fn;
+	pool->context = context;
+	pool->taskCount = taskCount;
+	pool->busyWorkers = pool->threadCount;
+	atomic_store_explicit(&pool->nextTask, 0, memory_order_relaxed);
+	++pool->job;
+
+	cnd_broadcast(&pool->wake);
+	mtx_unlock(&pool->lock);
+
+	RunTasks(pool, fn, context, taskCount);
+
+	mtx_lock(&pool->lock);
+	while (pool->busyWorkers > 0) cnd_wait(&pool->done, &pool->lock);
+	mtx_unlock(&pool->lock);
+}
+
+void PoolRelease(ThreadPool *pool)
+{
+	if (pool->threads)
+	{
+		mtx_lock(&pool->lock);
+		pool->quit = true;
+		cnd_broadcast(&pool->wake);
+		mtx_unlock(&pool->lock);
+
+		for (int i = 0; i < pool->threadCount; ++i) thrd_join(pool->threads[i], NULL);
+		free(pool->threads);
+	}
+
+	cnd_destroy(&pool->done);
+	cnd_destroy(&pool->wake);
+	mtx_destroy(&pool->lock);
+	*pool = (ThreadPool){0};
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <threads.h>
+
+// Runs numbered tasks on a fixed set of threads. The threads are started
+// once and sleep between jobs, so a job only costs a wake up.
+
+typedef void PoolTaskFn(void *context, size_t task);
+
+typedef struct ThreadPool_t
+{
+	thrd_t *threads;
+	int threadCount; // Worker threads, not counting the thread calling PoolRun
+
+	mtx_t lock;
+	cnd_t wake; // Signalled when a job starts or the pool shuts down
+	cnd_t done; // Signalled when a worker goes idle
+
+	// The current job, guarded by lock.
+	PoolTaskFn *fn;
+	void *context;
+	size_t taskCount;
+	unsigned job;    // Bumped for each new job
+	int busyWorkers; // Workers still on the current job
+	bool quit;
+
+	atomic_size_t nextTask;
+} ThreadPool;
+
+// Starts threadCount - 1 workers; the thread calling PoolRun is the last
+// one. Returns false if the threads could not be started.
+bool PoolInit(ThreadPool *pool, int threadCount);
+
+// Calls fn(context, task) for every task below taskCount, spread over the
+// pool in no particular order, and returns when all calls have returned.
+void PoolRun(ThreadPool *pool, size_t taskCount, PoolTaskFn *fn, void *context);
+
+void PoolRelease(ThreadPool *pool);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,226 @@
+#include "scan.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "cpu.h"
+
+#if CPU_X86
+#include <emmintrin.h>
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#endif
+
+typedef const char *ScanSpaceFn(const char *at, const char *end);
+typedef const char *ScanDigitsFn(const char *at, const char *end);
+
+static ScanSpaceFn ScanSpaceResolve;
+static ScanDigitsFn ScanDigitsResolve;
+
+static ScanSpaceFn *scanSpaceKernel = ScanSpaceResolve;
+static ScanDigitsFn *scanDigitsKernel = ScanDigitsResolve;
+
+static bool IsSpace(char c)
+{
+	return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+static bool IsDigit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+//
+// Scalar
+//
+
+static const char *ScanSpaceScalar(const char *at, const char *end)
+{
+	while (at < end && IsSpace(*at)) ++at;
+	return at;
+}
+
+static const char *ScanDigitsScalar(const char *at, const char *end)
+{
+	while (at < end && IsDigit(*at)) ++at;
+	return at;
+}
+
+#if CPU_X86
+
+static int LowestBit(unsigned mask)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return (int)index;
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+
+//
+// SSE2
+//
+
+static const char *ScanSpaceSse2(const char *at, const char *end)
+{
+	const __m128i space = _mm_set1_epi8(' ');
+	const __m128i belowTab = _mm_set1_epi8('\t' - 1);
+	const __m128i aboveReturn = _mm_set1_epi8('\r' + 1);
+
+	while (end - at >= 16)
+	{
+		__m128i chunk = _mm_loadu_si128((const __m128i *)at);
+
+		__m128i isControlSpace = _mm_and_si128(_mm_cmpgt_epi8(chunk, belowTab), _mm_cmplt_epi8(chunk, aboveReturn));
+		__m128i isSpace = _mm_or_si128(_mm_cmpeq_epi8(chunk, space), isControlSpace);
+
+		unsigned notSpaceMask = ~(unsigned)_mm_movemask_epi8(isSpace) & 0xffff;
+		if (notSpaceMask) return at + LowestBit(notSpaceMask);
+
+		at += 16;
+	}
+
+	return ScanSpaceScalar(at, end);
+}
+
+static const char *ScanDigitsSse2(const char *at, const char *end)
+{
+	const __m128i belowZero = _mm_set1_epi8('0' - 1);
+	const __m128i aboveNine = _mm_set1_epi8('9' + 1);
+
+	while (end - at >= 16)
+	{
+		__m128i chunk = _mm_loadu_si128((const __m128i *)at);
+		__m128i isDigit = _mm_and_si128(_mm_cmpgt_epi8(chunk, belowZero), _mm_cmplt_epi8(chunk, aboveNine));
+
+		unsigned notDigitMask = ~(unsigned)_mm_movemask_epi8(isDigit) & 0xffff;
+		if (notDigitMask) return at + LowestBit(notDigitMask);
+
+		at += 16;
+	}
+
+	return ScanDigitsScalar(at, end);
+}
+
+//
+// AVX2
+//
+
+TARGET_AVX2
+static const char *ScanSpaceAvx2(const char *at, const char *end)
+{
+	const __m256i space = _mm256_set1_epi8(' ');
+	const __m256i belowTab = _mm256_set1_epi8('\t' - 1);
+	const __m256i aboveReturn = _mm256_set1_epi8('\r' + 1);
+
+	while (end - at >= 32)
+	{
+		__m256i chunk = _mm256_loadu_si256((const __m256i *)at);
+
+		__m256i isControlSpace = _mm256_and_si256(_mm256_cmpgt_epi8(chunk, belowTab), _mm256_cmpgt_epi8(aboveReturn, chunk));
+		__m256i isSpace = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, space), isControlSpace);
+
+		unsigned notSpaceMask = ~(unsigned)_mm256_movemask_epi8(isSpace);
+		if (notSpaceMask) return at + LowestBit(notSpaceMask);
+
+		at += 32;
+	}
+
+	return ScanSpaceSse2(at, end);
+}
+
+TARGET_AVX2
+static const char *ScanDigitsAvx2(const char *at, const char *end)
+{
+	const __m256i belowZero = _mm256_set1_epi8('0' - 1);
+	const __m256i aboveNine = _mm256_set1_epi8('9' + 1);
+
+	while (end - at >= 32)
+	{
+		__m256i chunk = _mm256_loadu_si256((const __m256i *)at);
+		__m256i isDigit = _mm256_and_si256(_mm256_cmpgt_epi8(chunk, belowZero), _mm256_cmpgt_epi8(aboveNine, chunk));
+
+		unsigned notDigitMask = ~(unsigned)_mm256_movemask_epi8(isDigit);
+		if (notDigitMask) return at + LowestBit(notDigitMask);
+
+		at += 32;
+	}
+
+	return ScanDigitsSse2(at, end);
+}
+
+#endif // CPU_X86
+
+ScanKernel ScanUseKernel(ScanKernel preferred)
+{
+	ScanKernel kernel = SCAN_KERNEL_SCALAR;
+
+#if CPU_X86
+	// SSE2 is part of the x86-64 baseline.
+	kernel = SCAN_KERNEL_SSE2;
+	if (CpuHasAvx2()) kernel = SCAN_KERNEL_AVX2;
+#endif
+
+	if (kernel > preferred) kernel = preferred;
+
+	switch (kernel)
+	{
+#if CPU_X86
+		case SCAN_KERNEL_AVX2:
+			scanSpaceKernel = ScanSpaceAvx2;
+			scanDigitsKernel = ScanDigitsAvx2;
+			break;
+
+		case SCAN_KERNEL_SSE2:
+			scanSpaceKernel = ScanSpaceSse2;
+			scanDigitsKernel = ScanDigitsSse2;
+			break;
+#endif
+
+		default:
+			scanSpaceKernel = ScanSpaceScalar;
+			scanDigitsKernel = ScanDigitsScalar;
+			break;
+	}
+
+	return kernel;
+}
+
+void ScanPrepare(void)
+{
+	if (scanSpaceKernel == ScanSpaceResolve || scanDigitsKernel == ScanDigitsResolve)
+	{
+		ScanUseKernel(SCAN_KERNEL_AVX2);
+	}
+}
+
+static const char *ScanSpaceResolve(const char *at, const char *end)
+{
+	ScanUseKernel(SCAN_KERNEL_AVX2);
+	return scanSpaceKernel(at, end);
+}
+
+static const char *ScanDigitsResolve(const char *at, const char *end)
+{
+	ScanUseKernel(SCAN_KERNEL_AVX2);
+	return scanDigitsKernel(at, end);
+}
+
+const char *ScanSpace(const char *at, const char *end)
+{
+	// Most runs between tokens are zero or one character long, which is not
+	// worth a vector load.
+	if (at == end || !IsSpace(*at)) return at;
+	if (end - at == 1 || !IsSpace(at[1])) return at + 1;
+
+	return scanSpaceKernel(at, end);
+}
+
+const char *ScanDigits(const char *at, const char *end)
+{
+	return scanDigitsKernel(at, end);
+}
\ No newline at end of file
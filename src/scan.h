@@ -0,0 +1,28 @@
+#ifndef SCAN_H
+#define SCAN_H
+
+// Bulk character scanning used by the tokenizer. Each scan has a scalar,
+// an SSE2 and an AVX2 kernel; the best one the CPU supports is picked the
+// first time a scan runs.
+
+typedef enum
+{
+	SCAN_KERNEL_SCALAR,
+	SCAN_KERNEL_SSE2,
+	SCAN_KERNEL_AVX2,
+} ScanKernel;
+
+// Uses the best supported kernel no better than preferred, and returns it.
+ScanKernel ScanUseKernel(ScanKernel preferred);
+
+// Picks the best kernels now if no scan has picked them yet. Call it before
+// scanning on several threads at once.
+void ScanPrepare(void);
+
+// Returns the first non-whitespace character in [at, end), or end.
+const char *ScanSpace(const char *at, const char *end);
+
+// Returns the first character in [at, end) that is not a decimal digit, or end.
+const char *ScanDigits(const char *at, const char *end);
+
+#endif
\ No newline at end of file
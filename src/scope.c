@@ -0,0 +1,112 @@
+#include "scope.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+static uint32_t HashName(const char *chars, size_t len)
+{
+	// FNV-1a
+	uint32_t hash = 2166136261u;
+	for (size_t i = 0; i < len; ++i)
+	{
+		hash ^= (unsigned char)chars[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+// Returns the bucket holding the name, or the empty bucket it would go in.
+static size_t FindBucket(const Scope *scope, const char *chars, size_t len, uint32_t hash)
+{
+	size_t mask = scope->bucketCount - 1;
+
+	for (size_t bucket = hash & mask;; bucket = (bucket + 1) & mask)
+	{
+		Symbol symbol = scope->buckets[bucket];
+		if (symbol < 0) return bucket;
+
+		Ident name = scope->names[symbol];
+		if (scope->hashes[symbol] == hash && name.len == len && memcmp(name.chars, chars, len) == 0)
+		{
+			return bucket;
+		}
+	}
+}
+
+static void Rehash(Scope *scope, size_t bucketCount)
+{
+	free(scope->buckets);
+	scope->bucketCount = bucketCount;
+	scope->buckets = malloc(bucketCount * sizeof(*scope->buckets));
+	assert(scope->buckets && "Out of memory");
+	memset(scope->buckets, 0xff, bucketCount * sizeof(*scope->buckets));
+
+	size_t mask = bucketCount - 1;
+	for (Symbol symbol = 0; symbol < scope->count; ++symbol)
+	{
+		size_t bucket = scope->hashes[symbol] & mask;
+		while (scope->buckets[bucket] >= 0) bucket = (bucket + 1) & mask;
+		scope->buckets[bucket] = symbol;
+	}
+}
+
+Symbol ScopeFind(const Scope *scope, const char *chars, size_t len)
+{
+	if (scope->count == 0) return -1;
+
+	size_t bucket = FindBucket(scope, chars, len, HashName(chars, len));
+	return scope->buckets[bucket];
+}
+
+static Symbol Intern(Scope *scope, const char *chars, size_t len, bool view)
+{
+	uint32_t hash = HashName(chars, len);
+
+	if (2*(size_t)(scope->count + 1) > scope->bucketCount)
+	{
+		Rehash(scope, scope->bucketCount ? 2*scope->bucketCount : 64);
+	}
+
+	size_t bucket = FindBucket(scope, chars, len, hash);
+	if (scope->buckets[bucket] >= 0) return scope->buckets[bucket];
+
+	if (scope->count == scope->capacity)
+	{
+		scope->capacity = scope->capacity ? 2*scope->capacity : 16;
+		scope->names = realloc(scope->names, scope->capacity * sizeof(*scope->names));
+		scope->hashes = realloc(scope->hashes, scope->capacity * sizeof(*scope->hashes));
+		assert(scope->names && scope->hashes && "Out of memory");
+	}
+
+	Ident name = {
+		.chars = view ? chars : ArenaStrndup(&scope->copies, chars, len),
+		.len = len,
+	};
+
+	Symbol symbol = scope->count++;
+	scope->names[symbol] = name;
+	scope->hashes[symbol] = hash;
+	scope->buckets[bucket] = symbol;
+	return symbol;
+}
+
+Symbol ScopeSlot(Scope *scope, const char *chars, size_t len)
+{
+	return Intern(scope, chars, len, false);
+}
+
+Symbol ScopeSlotView(Scope *scope, const char *chars, size_t len)
+{
+	return Intern(scope, chars, len, true);
+}
+
+void ScopeFree(Scope *scope)
+{
+	ArenaRelease(&scope->copies);
+	free(scope->names);
+	free(scope->hashes);
+	free(scope->buckets);
+	*scope = (Scope){0};
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+#ifndef SCOPE_H
+#define SCOPE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "arena.h"
+
+typedef struct Ident_t
+{
+	const char *chars;
+	size_t len;
+} Ident;
+
+// An interned identifier: the index of its name in the scope. Equal names
+// have equal symbols, and the symbol of a variable is also its slot in the
+// values an expression is evaluated with.
+typedef int Symbol;
+
+// Interns identifiers: each distinct name is stored once, and gets the
+// next symbol, numbered from zero. The lexer interns every identifier as it
+// reads it, so tokens and expression nodes carry only symbols.
+typedef struct Scope_t
+{
+	Ident *names; // names[symbol]; null terminated, unless interned as a view
+	uint32_t *hashes; // hashes[symbol]
+	Arena copies; // Characters of the names that are not views
+	int count;
+	int capacity;
+
+	// Open addressing with linear probing. Each bucket holds a symbol, or -1
+	// when empty. Kept at most half full.
+	Symbol *buckets;
+	size_t bucketCount; // A power of two
+} Scope;
+
+// Returns the symbol of the name, or -1 if the scope has not seen it.
+Symbol ScopeFind(const Scope *scope, const char *chars, size_t len);
+
+// Returns the symbol of the name, giving it the next free one if new. A
+// new name is copied into the scope.
+Symbol ScopeSlot(Scope *scope, const char *chars, size_t len);
+
+// Like ScopeSlot, but a new name is kept as a view of chars rather than a
+// copy, so chars must outlive the scope.
+Symbol ScopeSlotView(Scope *scope, const char *chars, size_t len);
+
+void ScopeFree(Scope *scope);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,262 @@
+#include "table.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "decimal.h"
+
+static bool IsBlank(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+static bool IsDigit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+static const char *SkipBlanks(const char *at, const char *end)
+{
+	while (at < end && IsBlank(*at)) ++at;
+	return at;
+}
+
+// Reads the header line and returns the start of the next line.
+static const char *ParseHeader(const char *data, const char *end, Table *table)
+{
+	const char *lineEnd = memchr(data, '\n', end - data);
+	if (!lineEnd) lineEnd = end;
+
+	int capacity = 8;
+	table->names = malloc(capacity * sizeof(*table->names));
+	assert(table->names && "Out of memory");
+
+	const char *at = data;
+	for (;;)
+	{
+		const char *nameStart = SkipBlanks(at, lineEnd);
+		const char *nameEnd = nameStart;
+		while (nameEnd < lineEnd && *nameEnd != ',') ++nameEnd;
+
+		at = nameEnd;
+		while (nameEnd > nameStart && IsBlank(nameEnd[-1])) --nameEnd;
+
+		if (nameEnd == nameStart)
+		{
+			fprintf(stderr, "[ERROR] Table header: column %d has no name.\n", table->columnCount + 1);
+			return NULL;
+		}
+
+		if (table->columnCount == capacity)
+		{
+			capacity *= 2;
+			table->names = realloc(table->names, capacity * sizeof(*table->names));
+			assert(table->names && "Out of memory");
+		}
+
+		size_t nameLen = nameEnd - nameStart;
+		char *name = malloc(nameLen + 1);
+		assert(name && "Out of memory");
+		memcpy(name, nameStart, nameLen);
+		name[nameLen] = '\0';
+		table->names[table->columnCount++] = name;
+
+		if (at == lineEnd) break;
+		++at; // ','
+	}
+
+	return lineEnd < end ? lineEnd + 1 : end;
+}
+
+// Parses the number at the start of [at, end). Returns NULL if there is
+// none.
+static const char *ParseField(const char *at, const char *end, double *value)
+{
+	at = SkipBlanks(at, end);
+	const char *start = at;
+
+	bool negative = false;
+	if (at < end && (*at == '-' || *at == '+')) negative = *at++ == '-';
+
+	const char *digits = at;
+	while (at < end && IsDigit(*at)) ++at;
+	if (at < end && *at == '.')
+	{
+		++at;
+		while (at < end && IsDigit(*at)) ++at;
+	}
+
+	bool plain = at > digits && !(at == digits + 1 && *digits == '.');
+	if (plain && (at == end || *at == ',' || *at == '\n' || IsBlank(*at)))
+	{
+		double magnitude = ParseDecimal(digits, at);
+		*value = negative ? -magnitude : magnitude;
+		return at;
+	}
+
+	// Exponents, inf, nan and the like: rare enough to go through strtod,
+	// which needs a terminated copy.
+	const char *fieldEnd = start;
+	while (fieldEnd < end && *fieldEnd != ',' && *fieldEnd != '\n' && !IsBlank(*fieldEnd)) ++fieldEnd;
+
+	char buffer[64];
+	size_t fieldLen = fieldEnd - start;
+	if (fieldLen == 0 || fieldLen >= sizeof(buffer)) return NULL;
+
+	memcpy(buffer, start, fieldLen);
+	buffer[fieldLen] = '\0';
+
+	char *parsedEnd;
+	*value = strtod(buffer, &parsedEnd);
+	if (parsedEnd != buffer + fieldLen) return NULL;
+
+	return fieldEnd;
+}
+
+static void AllocValues(Table *table, size_t rowCapacity)
+{
+	size_t count = rowCapacity * table->columnCount;
+	table->values = malloc((count ? count : 1) * sizeof(*table->values));
+	assert(table->values && "Out of memory");
+}
+
+bool TableFromCsv(const char *data, size_t len, Table *table)
+{
+	*table = (Table){0};
+
+	const char *end = data + len;
+	const char *at = ParseHeader(data, end, table);
+	if (!at) goto error;
+
+	// Every row is a line, so the lines bound the rows. Rows are stored
+	// with this stride, then packed once the real count is known.
+	size_t rowCapacity = 0;
+	for (const char *scan = at; scan < end; ++rowCapacity)
+	{
+		const char *newline = memchr(scan, '\n', end - scan);
+		scan = newline ? newline + 1 : end;
+	}
+
+	AllocValues(table, rowCapacity);
+
+	int lineNumber = 2;
+	size_t row = 0;
+
+	for (; at < end; ++lineNumber)
+	{
+		const char *lineEnd = memchr(at, '\n', end - at);
+		if (!lineEnd) lineEnd = end;
+
+		if (SkipBlanks(at, lineEnd) == lineEnd)
+		{
+			at = lineEnd + (lineEnd < end);
+			continue;
+		}
+
+		for (int column = 0; column < table->columnCount; ++column)
+		{
+			double value;
+			const char *fieldEnd = ParseField(at, lineEnd, &value);
+			if (!fieldEnd)
+			{
+				fprintf(stderr, "[ERROR] Table line %d: value %d of '%s' is not a number.\n",
+					lineNumber, column + 1, table->names[column]);
+				goto error;
+			}
+
+			table->values[column * rowCapacity + row] = value;
+
+			at = SkipBlanks(fieldEnd, lineEnd);
+			bool last = column == table->columnCount - 1;
+			if (last ? at != lineEnd : (at == lineEnd || *at != ','))
+			{
+				fprintf(stderr, "[ERROR] Table line %d: expected %d values.\n", lineNumber, table->columnCount);
+				goto error;
+			}
+			if (!last) ++at; // ','
+		}
+
+		++row;
+		at = lineEnd + (lineEnd < end);
+	}
+
+	table->rowCount = row;
+
+	if (row < rowCapacity)
+	{
+		for (int column = 1; column < table->columnCount; ++column)
+		{
+			memmove(table->values + column * row, table->values + column * rowCapacity, row * sizeof(*table->values));
+		}
+	}
+
+	return true;
+
+error:
+	TableFree(table);
+	return false;
+}
+
+bool TableFromBinary(const char *data, size_t len, Table *table)
+{
+	*table = (Table){0};
+
+	const char *end = data + len;
+	const char *at = ParseHeader(data, end, table);
+	if (!at) goto error;
+
+	size_t rowSize = table->columnCount * sizeof(double);
+	size_t bodyLen = end - at;
+	if (bodyLen % rowSize != 0)
+	{
+		fprintf(stderr, "[ERROR] Binary table: %zu bytes of rows is not a whole number of %d column rows.\n",
+			bodyLen, table->columnCount);
+		goto error;
+	}
+
+	table->rowCount = bodyLen / rowSize;
+	AllocValues(table, table->rowCount);
+
+	// The rows need not be aligned after the header, so copy value by value
+	// while turning them into columns.
+	for (size_t row = 0; row < table->rowCount; ++row)
+	{
+		for (int column = 0; column < table->columnCount; ++column)
+		{
+			memcpy(&table->values[column * table->rowCount + row], at, sizeof(double));
+			at += sizeof(double);
+		}
+	}
+
+	return true;
+
+error:
+	TableFree(table);
+	return false;
+}
+
+int TableFindColumn(const Table *table, const char *name, size_t nameLen)
+{
+	for (int column = 0; column < table->columnCount; ++column)
+	{
+		if (strlen(table->names[column]) == nameLen && memcmp(table->names[column], name, nameLen) == 0) return column;
+	}
+
+	return -1;
+}
+
+const double *TableColumn(const Table *table, int column)
+{
+	assert(column >= 0 && column < table->columnCount);
+	return table->values + column * table->rowCount;
+}
+
+void TableFree(Table *table)
+{
+	for (int column = 0; column < table->columnCount; ++column) free(table->names[column]);
+	free(table->names);
+	free(table->values);
+	*table = (Table){0};
+}
\ No newline at end of file
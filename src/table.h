@@ -0,0 +1,33 @@
+#ifndef TABLE_H
+#define TABLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Rows of variable values, stored column by column so a column can be
+// handed straight to RunProgramColumns.
+//
+// Both formats start with a header line of comma separated column names.
+// In a CSV table each following non-blank line is a row of comma separated
+// numbers. In a binary table the header is followed by the rows as native
+// doubles, one after the other.
+typedef struct Table_t
+{
+	char **names;
+	int columnCount;
+	size_t rowCount;
+	double *values; // Column c is values[c*rowCount .. (c+1)*rowCount)
+} Table;
+
+// Return false, after printing what is wrong, for a malformed table.
+bool TableFromCsv(const char *data, size_t len, Table *table);
+bool TableFromBinary(const char *data, size_t len, Table *table);
+
+// Returns the index of the named column, or -1.
+int TableFindColumn(const Table *table, const char *name, size_t nameLen);
+
+const double *TableColumn(const Table *table, int column);
+
+void TableFree(Table *table);
+
+#endif
\ No newline at end of file
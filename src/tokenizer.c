@@ -1,15 +1,64 @@
 #include "tokenizer.h"
+#include "decimal.h"
+#include "scan.h"
 
 #include <assert.h>
-#include <ctype.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-static int RemainingChars(TokenStream *ts)
+#define TOKEN_BUFFER_MAX_GUESS (1 << 20)
+
+// What a character starts, in the low bits, and whether it can continue an
+// identifier. Classifying by table keeps the lexer independent of the C
+// locale, and is defined for every byte, negative chars included.
+enum
+{
+	CHAR_OPERATOR = 0, // A token by itself
+	CHAR_SPACE    = 1,
+	CHAR_DIGIT    = 2,
+	CHAR_LETTER   = 3,
+	CHAR_END      = 4, // '\0' ends the input early
+	CHAR_START_MASK = 0x7,
+
+	CHAR_IDENT    = 0x8,
+};
+
+#define O CHAR_OPERATOR
+#define S CHAR_SPACE
+#define D (CHAR_DIGIT | CHAR_IDENT)
+#define L (CHAR_LETTER | CHAR_IDENT)
+#define U (CHAR_OPERATOR | CHAR_IDENT)
+#define E CHAR_END
+
+static const unsigned char charClasses[256] = {
+	E, O, O, O, O, O, O, O, O, S, S, S, S, S, O, O, // 0x00
+	O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, // 0x10
+	S, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, // 0x20  !"#$%&'()*+,-./
+	D, D, D, D, D, D, D, D, D, D, O, O, O, O, O, O, // 0x30 0-9 :;<=>?
+	O, L, L, L, L, L, L, L, L, L, L, L, L, L, L, L, // 0x40 @A-O
+	L, L, L, L, L, L, L, L, L, L, L, O, O, O, O, U, // 0x50 P-Z [\]^_
+	O, L, L, L, L, L, L, L, L, L, L, L, L, L, L, L, // 0x60 `a-o
+	L, L, L, L, L, L, L, L, L, L, L, O, O, O, O, O, // 0x70 p-z {|}~
+	// Bytes from 0x80 up are all operators.
+};
+
+#undef O
+#undef S
+#undef D
+#undef L
+#undef U
+#undef E
+
+static unsigned CharClass(char c)
+{
+	return charClasses[(unsigned char)c];
+}
+
+static size_t RemainingChars(TokenStream *ts)
 {
-	return (int)(ts->end - ts->at);
+	return (size_t)(ts->end - ts->at);
 }
 
 static char PeekChar(TokenStream *ts)
@@ -24,53 +73,42 @@ static char PeekChar(TokenStream *ts)
 static char Advance(TokenStream *ts)
 {
 	assert(ts->at < ts->end);
-
-	char c = *ts->at++;
-
-	if (c == '\n')
-	{
-		ts->lineStart = ts->at;
-		++ts->lineCount;
-	}
-
-	return c;
+	return *ts->at++;
 }
 
 static void EatSpace(TokenStream *ts)
 {
-	while (ts->at < ts->end && isspace(*ts->at)) Advance(ts);
+	ts->at = ScanSpace(ts->at, ts->end);
 }
 
-int GetColumn(TokenStream *ts)
+static size_t Offset(TokenStream *ts)
 {
-	int result = (int)(ts->at - ts->lineStart);
-	assert(result >= 0);
-	return result;
+	return (size_t)(ts->at - ts->start);
 }
 
 TokenStream TokenStreamFromCStr(const char *str)
 {
-	return (TokenStream){str, str + strlen(str), str, 0};
+	return TokenStreamFromBuffer(str, strlen(str));
+}
+
+TokenStream TokenStreamFromBuffer(const char *start, size_t len)
+{
+	return (TokenStream){start, start, start + len, NULL, false};
 }
 
 static void
 NumberToken(TokenStream *ts, Token *outToken)
 {
-	char buf[128] = {0};
 	const char *tokStart = ts->at;
 
-	// TODO(jkk): only one radix point please.
-	char c;
-	while ((c = PeekChar(ts)) && isdigit(c) || c == '.') {
-		Advance(ts);
+	ts->at = ScanDigits(ts->at, ts->end);
+	if (PeekChar(ts) == '.')
+	{
+		ts->at = ScanDigits(ts->at + 1, ts->end);
 	}
 
-	unsigned long copyLength = (unsigned long)(ts->at - tokStart) & (sizeof(buf) - 1);
-	memcpy(buf, tokStart, copyLength);
-	buf[copyLength] = '\0';
-
 	outToken->type = TOK_NUMBER;
-	outToken->as.number = strtod(buf, NULL);
+	outToken->as.number = ParseDecimal(tokStart, ts->at);
 }
 
 static void
@@ -78,18 +116,38 @@ IdentToken(TokenStream *ts, Token *outToken)
 {
 	const char *tokStart = ts->at;
 
-	char c;
+	// The first character is already known to be a letter.
 	do {
-		c = Advance(ts);
-	} while (isalnum(c) || c == '_');
+		++ts->at;
+	} while (ts->at < ts->end && (CharClass(*ts->at) & CHAR_IDENT));
 
-	Ident ident = {0};
-	ident.len = (unsigned long)(ts->at - tokStart);
-	ident.chars = calloc(ident.len + 1, sizeof(*ident.chars));
-	memcpy(ident.chars, tokStart, ident.len);
+	assert(ts->scope && "Identifiers need a scope to be interned in");
 
 	outToken->type = TOK_IDENT;
-	outToken->as.ident = ident;
+	size_t len = (size_t)(ts->at - tokStart);
+	outToken->as.ident = ts->identViews
+		? ScopeSlotView(ts->scope, tokStart, len)
+		: ScopeSlot(ts->scope, tokStart, len);
+}
+
+// Lexes the token at ts->at, after the whitespace before it.
+static void ScanToken(TokenStream *ts, Token *token)
+{
+	char c = PeekChar(ts);
+
+	// Whitespace has been eaten, so it cannot start a token here.
+	switch (CharClass(c) & CHAR_START_MASK)
+	{
+		case CHAR_DIGIT: NumberToken(ts, token); break;
+		case CHAR_LETTER: IdentToken(ts, token); break;
+		case CHAR_END: token->type = TOK_INPUT_END; break;
+
+		default:
+		{
+			token->type = c;
+			Advance(ts);
+		} break;
+	}
 }
 
 Token
@@ -98,24 +156,112 @@ NextToken(TokenStream *ts)
 	EatSpace(ts);
 
 	Token token = {0};
-	token.line = ts->lineCount;
-	token.column = GetColumn(ts);
+	token.offset = Offset(ts);
+	ScanToken(ts, &token);
 
-	char c = PeekChar(ts);
+	return token;
+}
 
-	if (isdigit(c)) {
-		NumberToken(ts, &token);
-	}
-	else if (isalpha(c)) {
-		IdentToken(ts, &token);
+#define GROW_ARRAY(array, count, capacity, initial) \
+	do { \
+		if ((count) == (capacity)) \
+		{ \
+			(capacity) = (capacity) ? 2*(capacity) : (initial); \
+			(array) = realloc((array), (capacity) * sizeof(*(array))); \
+			assert((array) && "Out of memory"); \
+		} \
+	} while (0)
+
+void LexTokens(TokenStream *ts, TokenBuffer *buffer)
+{
+	LexTokenBatch(ts, buffer, SIZE_MAX);
+}
+
+bool LexTokenBatch(TokenStream *ts, TokenBuffer *buffer, size_t maxCount)
+{
+	assert(maxCount > 0);
+
+	buffer->count = 0;
+	buffer->numberCount = 0;
+	buffer->identCount = 0;
+	buffer->start = ts->start;
+
+	assert((size_t)(ts->end - ts->start) <= TOKEN_STREAM_MAX_BYTES && "Input too large for 32-bit token offsets");
+
+	// Every token but the last is at least one character, or is separated by
+	// one, so a fraction of the input length is a good first guess. Huge
+	// inputs grow from a capped guess instead of reserving gigabytes at once.
+	size_t expectedCount = RemainingChars(ts)/4 + 16;
+	if (expectedCount > TOKEN_BUFFER_MAX_GUESS) expectedCount = TOKEN_BUFFER_MAX_GUESS;
+	if (expectedCount > maxCount) expectedCount = maxCount;
+	if (buffer->capacity < expectedCount)
+	{
+		free(buffer->tokens);
+		buffer->capacity = expectedCount;
+		buffer->tokens = malloc(buffer->capacity * sizeof(*buffer->tokens));
+		assert(buffer->tokens && "Out of memory");
 	}
-	else if (c == '\0') {
-		token.type = TOK_INPUT_END;
+
+	while (buffer->count < maxCount)
+	{
+		GROW_ARRAY(buffer->tokens, buffer->count, buffer->capacity, 16);
+
+		EatSpace(ts);
+
+		Token token = {0};
+		uint32_t offset = (uint32_t)Offset(ts);
+		ScanToken(ts, &token);
+
+		buffer->tokens[buffer->count++] = (PackedToken){token.type, offset};
+
+		if (token.type == TOK_NUMBER)
+		{
+			GROW_ARRAY(buffer->numbers, buffer->numberCount, buffer->numberCapacity, 16);
+			buffer->numbers[buffer->numberCount++] = token.as.number;
+		}
+		else if (token.type == TOK_IDENT)
+		{
+			GROW_ARRAY(buffer->idents, buffer->identCount, buffer->identCapacity, 16);
+			buffer->idents[buffer->identCount++] = token.as.ident;
+		}
+		else if (token.type == TOK_INPUT_END) return true;
 	}
-	else {
-		token.type = c;
-		Advance(ts);
+
+	return false;
+}
+
+#undef GROW_ARRAY
+
+void TokenBufferFree(TokenBuffer *buffer)
+{
+	free(buffer->tokens);
+	free(buffer->numbers);
+	free(buffer->idents);
+	*buffer = (TokenBuffer){0};
+}
+
+static void Locate(const char *start, size_t offset, int *line, int *column)
+{
+	const char *at = start;
+	const char *target = start + offset;
+
+	*line = 0;
+	while ((at = memchr(at, '\n', (size_t)(target - at))))
+	{
+		++*line;
+		start = ++at;
 	}
 
-	return token;
+	*column = (int)(target - start);
 }
+
+void TokenStreamLocation(const TokenStream *ts, size_t offset, int *line, int *column)
+{
+	assert(offset <= (size_t)(ts->end - ts->start));
+	Locate(ts->start, offset, line, column);
+}
+
+void TokenBufferLocation(const TokenBuffer *buffer, uint32_t offset, int *line, int *column)
+{
+	Locate(buffer->start, offset, line, column);
+}
\ No newline at end of file
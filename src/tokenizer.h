@@ -1,7 +1,11 @@
 #ifndef TOKENIZER_H
 #define TOKENIZER_H
 
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+
+#include "scope.h"
 
 typedef enum TokenType_t
 {
@@ -16,35 +20,81 @@ typedef enum TokenType_t
 	TOK_IDENT,
 } TokenType;
 
-typedef struct Ident_t
-{
-	char *chars;
-	size_t len;
-} Ident;
-
 typedef struct Token_t
 {
 	int type;
-	int line;
-	int column;
+	size_t offset; // Of the first character, from the start of the stream
 	union {
 		double number;
-		Ident ident;
+		Symbol ident; // Name in the scope of the stream
 	} as;
 } Token;
 
+// Tokens only carry byte offsets; lines and columns are worked out from the
+// offset when a diagnostic asks for them, so lexing does no line bookkeeping.
 typedef struct TokenStream_t
 {
+	const char *const start;
 	const char *at;
 	const char *const end;
-	const char *lineStart;
-	int lineCount;
+	Scope *scope; // Identifiers are interned here; required if the input has any
+
+	// Intern new names as views into the input instead of copies. Lexing
+	// then allocates nothing per identifier, but the input has to outlive
+	// the scope.
+	bool identViews;
 } TokenStream;
 
+// 8 byte form of a token for the pre-lexed path. Numbers and identifiers
+// keep their values in arrays of their own, in the order of the tokens, and
+// the location is worked out from the offset only when it is asked for.
+typedef struct PackedToken_t
+{
+	int32_t type;    // TokenType, or the character of any other token
+	uint32_t offset; // Of the first character, from the start of the stream
+} PackedToken;
+
+// Longest stream LexTokens and LexTokenBatch take, so every offset, that of
+// TOK_INPUT_END included, fits a PackedToken. Callers reject longer inputs.
+#define TOKEN_STREAM_MAX_BYTES ((size_t)UINT32_MAX - 1)
+
+// Contiguous array of every token in an input, ending with TOK_INPUT_END.
+typedef struct TokenBuffer_t
+{
+	PackedToken *tokens;
+	size_t count;
+	size_t capacity;
+
+	double *numbers; // Value of each TOK_NUMBER, in order
+	size_t numberCount;
+	size_t numberCapacity;
+
+	Symbol *idents; // Symbol of each TOK_IDENT, in order
+	size_t identCount;
+	size_t identCapacity;
+
+	// Start of the stream the tokens were lexed from, for TokenBufferLocation.
+	// The input has to outlive the calls to it.
+	const char *start;
+} TokenBuffer;
+
 TokenStream TokenStreamFromCStr(const char *str);
+TokenStream TokenStreamFromBuffer(const char *start, size_t len);
 
 Token NextToken(TokenStream *ts);
 
-int GetColumn(TokenStream *ts);
+// Lexes the rest of the stream in one pass into buffer, replacing its
+// contents but reusing its memory.
+void LexTokens(TokenStream *ts, TokenBuffer *buffer);
+
+// Like LexTokens, but stops after maxCount tokens. Returns true if the
+// stream has ended, in which case the last token is TOK_INPUT_END.
+bool LexTokenBatch(TokenStream *ts, TokenBuffer *buffer, size_t maxCount);
+void TokenBufferFree(TokenBuffer *buffer);
+
+// Line and column, both from 0, of the character at offset from the start
+// of the stream, found by counting the newlines before it.
+void TokenStreamLocation(const TokenStream *ts, size_t offset, int *line, int *column);
+void TokenBufferLocation(const TokenBuffer *buffer, uint32_t offset, int *line, int *column);
 
 #endif
\ No newline at end of file
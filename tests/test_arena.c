@@ -0,0 +1,92 @@
+#include <stdint.h>
+
+#include "unity.h"
+#include "unity_internals.h"
+#include "../src/arena.h"
+
+static Arena arena;
+
+void setUp(){}
+void tearDown()
+{
+	ArenaRelease(&arena);
+	arena = (Arena){0};
+}
+
+void TEST_ArenaAlloc_TwoAllocations_DistinctZeroedAndAligned(void)
+{
+	// Arrange, Act
+	unsigned char *a = ArenaAlloc(&arena, 3);
+	unsigned char *b = ArenaAlloc(&arena, 24);
+
+	// Assert
+	TEST_ASSERT_NOT_NULL(a);
+	TEST_ASSERT_NOT_NULL(b);
+	TEST_ASSERT_TRUE(b >= a + 3);
+	TEST_ASSERT_EQUAL_UINT64(0, (uintptr_t)b % _Alignof(double));
+	for (int i = 0; i < 24; ++i) TEST_ASSERT_EQUAL_UINT8(0, b[i]);
+}
+
+void TEST_ArenaAlloc_LargerThanBlock_Succeeds(void)
+{
+	// Arrange
+	arena.minimumBlockSize = 64;
+
+	// Act
+	unsigned char *big = ArenaAlloc(&arena, 4096);
+	big[4095] = 1;
+	unsigned char *small = ArenaAlloc(&arena, 8);
+
+	// Assert
+	TEST_ASSERT_NOT_NULL(big);
+	TEST_ASSERT_NOT_NULL(small);
+	TEST_ASSERT_EQUAL_UINT8(1, big[4095]);
+}
+
+void TEST_ArenaStrndup_PartOfString_NullTerminatedCopy(void)
+{
+	// Arrange, Act
+	char *copy = ArenaStrndup(&arena, "variable", 3);
+
+	// Assert
+	TEST_ASSERT_EQUAL_STRING("var", copy);
+}
+
+void TEST_ArenaRelease_AfterAllocations_ArenaEmpty(void)
+{
+	// Arrange
+	for (int i = 0; i < 1000; ++i) ArenaAlloc(&arena, 1000);
+
+	// Act
+	ArenaRelease(&arena);
+
+	// Assert
+	TEST_ASSERT_NULL(arena.current);
+}
+
+void TEST_ArenaReset_AfterManyAllocations_KeepsOneBlockForReuse(void)
+{
+	// Arrange
+	arena.minimumBlockSize = 64;
+	for (int i = 0; i < 100; ++i) ArenaAlloc(&arena, 100);
+	void *lastBlock = arena.current;
+
+	// Act
+	ArenaReset(&arena);
+	unsigned char *reused = ArenaAlloc(&arena, 100);
+
+	// Assert
+	TEST_ASSERT_EQUAL_PTR(lastBlock, arena.current);
+	TEST_ASSERT_EQUAL_UINT8(0, reused[99]);
+}
+
+int main(void)
+{
+	UNITY_BEGIN();
+	RUN_TEST(TEST_ArenaAlloc_TwoAllocations_DistinctZeroedAndAligned);
+	RUN_TEST(TEST_ArenaAlloc_LargerThanBlock_Succeeds);
+	RUN_TEST(TEST_ArenaStrndup_PartOfString_NullTerminatedCopy);
+	RUN_TEST(TEST_ArenaReset_AfterManyAllocations_KeepsOneBlockForReuse);
+	RUN_TEST(TEST_ArenaRelease_AfterAllocations_ArenaEmpty);
+	return UNITY_END();
+}
\ No newline at end of file
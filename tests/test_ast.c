@@ -0,0 +1,131 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity.h"
+#include "unity_internals.h"
+#include "../src/tokenizer.h"
+#include "../src/parser.h"
+#include "../src/ast.h"
+
+static Parser parser;
+static Ast ast;
+
+void setUp() {}
+void tearDown()
+{
+	AstFree(&ast);
+	ParserRelease(&parser);
+}
+
+static Expr *ArrangeExpr(const char *cstr)
+{
+	TokenStream ts = TokenStreamFromCStr(cstr);
+	ParserInit(&parser, &ts);
+	return ParseExpression(&parser, 0, (Token){TOK_INPUT_END});
+}
+
+void TEST_AstFromExpr_Binops_PostOrderWithLeftOperandIndices(void)
+{
+	// Arrange
+	Expr *expr = ArrangeExpr("1 - 2 * -x");
+
+	// Act
+	AstFromExpr(&ast, expr);
+
+	// Assert
+	TEST_ASSERT_EQUAL_size_t(8, sizeof(AstNode));
+	TEST_ASSERT_EQUAL_UINT32(5, ast.count);
+	TEST_ASSERT_EQUAL_UINT32(2, ast.constantCount);
+
+	AstNode root = ast.nodes[4];
+	TEST_ASSERT_EQUAL_INT32(EXPR_BINOP, root.type);
+	TEST_ASSERT_EQUAL_INT32('-', root.op);
+	TEST_ASSERT_EQUAL_UINT32(0, root.operand);
+
+	AstNode product = ast.nodes[3];
+	TEST_ASSERT_EQUAL_INT32('*', product.op);
+	TEST_ASSERT_EQUAL_UINT32(1, product.operand);
+
+	AstNode variable = ast.nodes[2];
+	TEST_ASSERT_EQUAL_INT32(EXPR_VARIABLE, variable.type);
+	TEST_ASSERT_EQUAL_INT32(EXPR_FLAG_NEGATED, variable.flags);
+	TEST_ASSERT_EQUAL_STRING("x", ast.names[variable.operand].chars);
+
+	TEST_ASSERT_EQUAL_DOUBLE(2, ast.constants[ast.nodes[1].operand]);
+}
+
+void TEST_EvalAst_Expressions_SameAsEvalExpr(void)
+{
+	static const char *inputs[] = {
+		"(1 + 2*(3 - 4^0))/7 - 5^2 + -(2^-1) * 3",
+		"x = 2^0.5 + -(y = 3)",
+		"-(a = 4) - -a * x^y",
+		"2^3^2 / -(4 - -5) * 6 + x^-2.5",
+	};
+
+	for (size_t i = 0; i < sizeof(inputs)/sizeof(*inputs); ++i)
+	{
+		// Arrange
+		Expr *expr = ArrangeExpr(inputs[i]);
+		AstFromExpr(&ast, expr);
+		double treeVariables[3] = {1.5, 2.5, 3.5};
+		double astVariables[3] = {1.5, 2.5, 3.5};
+
+		// Act
+		double actual = EvalAst(&ast, astVariables);
+
+		// Assert
+		double expected = EvalExpr(expr, treeVariables);
+		TEST_ASSERT_EQUAL_MEMORY_MESSAGE(&expected, &actual, sizeof(double), inputs[i]);
+		TEST_ASSERT_EQUAL_MEMORY_MESSAGE(treeVariables, astVariables, sizeof(treeVariables), inputs[i]);
+		ParserRelease(&parser);
+	}
+}
+
+void TEST_AstFromExpr_AfterParserReleased_StillEvaluatesAndNamesVariables(void)
+{
+	// Arrange
+	AstFromExpr(&ast, ArrangeExpr("total = price * 3"));
+	ParserRelease(&parser);
+	double variables[2] = {0, 4};
+
+	// Act
+	double actual = EvalAst(&ast, variables);
+
+	// Assert
+	TEST_ASSERT_EQUAL_DOUBLE(12, actual);
+	TEST_ASSERT_EQUAL_DOUBLE(12, variables[0]);
+	TEST_ASSERT_EQUAL_STRING("total", ast.names[0].chars);
+	TEST_ASSERT_EQUAL_STRING("price", ast.names[1].chars);
+}
+
+void TEST_AstBytes_LongSum_LessThanHalfOfExprNodes(void)
+{
+	// Arrange
+	const int count = 100000;
+	char *input = malloc(2*count);
+	for (int i = 0; i < count; ++i) memcpy(input + 2*i, "x+", 2);
+	memcpy(input + 2*count - 2, "1", 2);
+	Expr *expr = ArrangeExpr(input);
+	double variables[1] = {0.5};
+
+	// Act
+	AstFromExpr(&ast, expr);
+
+	// Assert
+	TEST_ASSERT_EQUAL_UINT32(2*count - 1, ast.count);
+	TEST_ASSERT_LESS_THAN_size_t(ast.count * sizeof(Expr) / 2, AstBytes(&ast));
+	TEST_ASSERT_EQUAL_DOUBLE((count - 1) * 0.5 + 1, EvalAst(&ast, variables));
+	free(input);
+}
+
+int main(void)
+{
+	UNITY_BEGIN();
+	RUN_TEST(TEST_AstFromExpr_Binops_PostOrderWithLeftOperandIndices);
+	RUN_TEST(TEST_EvalAst_Expressions_SameAsEvalExpr);
+	RUN_TEST(TEST_AstFromExpr_AfterParserReleased_StillEvaluatesAndNamesVariables);
+	RUN_TEST(TEST_AstBytes_LongSum_LessThanHalfOfExprNodes);
+	return UNITY_END();
+}
\ No newline at end of file
@@ -0,0 +1,180 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity.h"
+#include "unity_internals.h"
+#include "../src/tokenizer.h"
+#include "../src/parser.h"
+#include "../src/bytecode.h"
+
+static Parser parser;
+static Program program;
+
+void setUp() {}
+void tearDown()
+{
+	ProgramFree(&program);
+	ParserRelease(&parser);
+}
+
+static Expr *ArrangeExpr(const char *cstr)
+{
+	TokenStream ts = TokenStreamFromCStr(cstr);
+	ParserInit(&parser, &ts);
+	return ParseExpression(&parser, 0, (Token){TOK_INPUT_END});
+}
+
+void TEST_CompileExpr_SingleAddition_PushPushAdd(void)
+{
+	// Arrange
+	Expr *expr = ArrangeExpr("1 + 2");
+
+	// Act
+	program = CompileExpr(expr);
+
+	// Assert
+	TEST_ASSERT_EQUAL_INT32(3, program.codeLen);
+	TEST_ASSERT_EQUAL_INT32(OPC_PUSH, INSTRUCTION_OPCODE(program.code[0]));
+	TEST_ASSERT_EQUAL_INT32(OPC_PUSH, INSTRUCTION_OPCODE(program.code[1]));
+	TEST_ASSERT_EQUAL_INT32(OPC_ADD, INSTRUCTION_OPCODE(program.code[2]));
+	TEST_ASSERT_EQUAL_INT32(2, program.maxStackDepth);
+}
+
+void TEST_CompileExpr_NegatedParens_EndsWithNeg(void)
+{
+	// Arrange
+	Expr *expr = ArrangeExpr("-(1 + 2)");
+
+	// Act
+	program = CompileExpr(expr);
+
+	// Assert
+	TEST_ASSERT_EQUAL_INT32(OPC_NEG, INSTRUCTION_OPCODE(program.code[program.codeLen - 1]));
+}
+
+void TEST_RunProgram_ComplicatedExpression_SameAsEvalExpr(void)
+{
+	// Arrange
+	Expr *expr = ArrangeExpr("(1 + 2*(3 - 4^0))/7 - 5^2 + -(2^-1) * 3");
+	program = CompileExpr(expr);
+
+	// Act
+	double actual = RunProgram(&program, NULL);
+
+	// Assert
+	TEST_ASSERT_EQUAL_DOUBLE(EvalExpr(expr, NULL), actual);
+}
+
+void TEST_RunProgram_DeeperThanLocalStack_SameAsEvalExpr(void)
+{
+	// Arrange
+	char input[1024] = {0};
+	int len = 0;
+	for (int i = 0; i < 100; ++i) len += sprintf(input + len, "%d^(", 1 + i % 2);
+	len += sprintf(input + len, "1");
+	for (int i = 0; i < 100; ++i) input[len++] = ')';
+
+	Expr *expr = ArrangeExpr(input);
+	program = CompileExpr(expr);
+
+	// Act
+	double actual = RunProgram(&program, NULL);
+
+	// Assert
+	TEST_ASSERT_TRUE(program.maxStackDepth > 64);
+	TEST_ASSERT_EQUAL_DOUBLE(EvalExpr(expr, NULL), actual);
+}
+void TEST_RunProgram_AssignmentsAndReads_SameAsEvalExpr(void)
+{
+	// Arrange
+	double treeVariables[2] = {0, 0};
+	double vmVariables[2] = {0, 0};
+	Expr *expr = ArrangeExpr("-(a = 3) * (b = a^2) - b");
+	program = CompileExpr(expr);
+
+	// Act
+	double actual = RunProgram(&program, vmVariables);
+
+	// Assert
+	TEST_ASSERT_EQUAL_DOUBLE(EvalExpr(expr, treeVariables), actual);
+	TEST_ASSERT_EQUAL_DOUBLE(treeVariables[0], vmVariables[0]);
+	TEST_ASSERT_EQUAL_DOUBLE(treeVariables[1], vmVariables[1]);
+	TEST_ASSERT_EQUAL_DOUBLE(9.0, vmVariables[1]);
+}
+
+void TEST_CompileExpr_ConstantPowers_NoCallsToPow(void)
+{
+	// Arrange
+	double variables[1] = {1.1};
+	Expr *expr = ArrangeExpr("x^2 + x^0.5 - x^-3.5 + x^x");
+
+	// Act
+	program = CompileExpr(expr);
+
+	// Assert
+	int powCount = 0, sqrtCount = 0, powNCount = 0;
+	for (int i = 0; i < program.codeLen; ++i)
+	{
+		Opcode opcode = INSTRUCTION_OPCODE(program.code[i]);
+		powCount += opcode == OPC_POW;
+		sqrtCount += opcode == OPC_SQRT;
+		if (opcode == OPC_POWN)
+		{
+			++powNCount;
+			TEST_ASSERT_TRUE(INSTRUCTION_SIGNED_OPERAND(program.code[i]) == 4 || INSTRUCTION_SIGNED_OPERAND(program.code[i]) == -7);
+		}
+	}
+	TEST_ASSERT_EQUAL_INT32(1, powCount);
+	TEST_ASSERT_EQUAL_INT32(1, sqrtCount);
+	TEST_ASSERT_EQUAL_INT32(2, powNCount);
+	TEST_ASSERT_EQUAL_DOUBLE(EvalExpr(expr, variables), RunProgram(&program, variables));
+}
+
+void TEST_RunProgram_MillionTermSum_Expected(void)
+{
+	// Arrange
+	const int count = 1000000;
+	char *input = malloc(2*count);
+	for (int i = 0; i < count; ++i) memcpy(input + 2*i, "x+", 2);
+	input[2*count - 1] = '\0';
+	program = CompileExpr(ArrangeExpr(input));
+	double variables[1] = {0.5};
+
+	// Act
+	double actual = RunProgram(&program, variables);
+
+	// Assert
+	TEST_ASSERT_EQUAL_DOUBLE(count * 0.5, actual);
+	TEST_ASSERT_EQUAL_INT32(2*count - 1, program.codeLen);
+	free(input);
+}
+
+void TEST_CompileExpr_SlotPastOperandLimit_Error(void)
+{
+	// Arrange
+	Expr variable = {.type = EXPR_VARIABLE, .as.variable.slot = PROGRAM_OPERAND_LIMIT};
+	Expr number = {.type = EXPR_NUMBER, .as.number = 1};
+	Expr sum = {.type = EXPR_BINOP, .as.binop = {OP_ADD, &number, &variable}};
+
+	// Act
+	program = CompileExpr(&sum);
+
+	// Assert
+	TEST_ASSERT_NOT_NULL(program.error);
+	TEST_ASSERT_EQUAL_INT32(0, program.codeLen);
+}
+
+int main(void)
+{
+	UNITY_BEGIN();
+	RUN_TEST(TEST_CompileExpr_SingleAddition_PushPushAdd);
+	RUN_TEST(TEST_CompileExpr_NegatedParens_EndsWithNeg);
+	RUN_TEST(TEST_RunProgram_ComplicatedExpression_SameAsEvalExpr);
+	RUN_TEST(TEST_RunProgram_DeeperThanLocalStack_SameAsEvalExpr);
+	RUN_TEST(TEST_RunProgram_AssignmentsAndReads_SameAsEvalExpr);
+	RUN_TEST(TEST_CompileExpr_ConstantPowers_NoCallsToPow);
+	RUN_TEST(TEST_RunProgram_MillionTermSum_Expected);
+	RUN_TEST(TEST_CompileExpr_SlotPastOperandLimit_Error);
+	return UNITY_END();
+}
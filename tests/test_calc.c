@@ -0,0 +1,138 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity.h"
+#include "unity_internals.h"
+#include "../src/calc.h"
+
+static CalcExpr *expr;
+
+void setUp() {}
+void tearDown()
+{
+	CalcRelease(expr);
+	expr = NULL;
+}
+
+static CalcExpr *ArrangeCompiled(const char *source)
+{
+	return CalcCompile(source, strlen(source), NULL);
+}
+
+void TEST_CalcCompile_SourceWithVariables_SlotsInOrderOfAppearance(void)
+{
+	// Arrange, Act
+	expr = ArrangeCompiled("rate * hours + rate");
+
+	// Assert
+	TEST_ASSERT_NOT_NULL(expr);
+	TEST_ASSERT_EQUAL_INT32(2, CalcVariableCount(expr));
+	TEST_ASSERT_EQUAL_STRING("rate", CalcVariableName(expr, 0));
+	TEST_ASSERT_EQUAL_STRING("hours", CalcVariableName(expr, 1));
+	TEST_ASSERT_EQUAL_INT32(1, CalcVariableSlot(expr, "hours"));
+	TEST_ASSERT_EQUAL_INT32(-1, CalcVariableSlot(expr, "minutes"));
+}
+
+void TEST_CalcCompile_SyntaxError_NullWithErrorLocation(void)
+{
+	// Arrange
+	CalcError error = {0};
+	const char *source = "1 +\n  * 2";
+
+	// Act
+	expr = CalcCompile(source, strlen(source), &error);
+
+	// Assert
+	TEST_ASSERT_NULL(expr);
+	TEST_ASSERT_EQUAL_INT32(1, error.line);
+	TEST_ASSERT_EQUAL_INT32(2, error.column);
+	TEST_ASSERT_TRUE(strlen(error.message) > 0);
+}
+
+void TEST_CalcCompile_EmptySource_Null(void)
+{
+	// Arrange
+	CalcError error = {0};
+
+	// Act
+	expr = CalcCompile("  ", 2, &error);
+
+	// Assert
+	TEST_ASSERT_NULL(expr);
+	TEST_ASSERT_EQUAL_STRING("Empty expression", error.message);
+}
+
+void TEST_CalcCompile_LongerThanTokenOffsets_NullWithError(void)
+{
+	// Arrange
+	CalcError error = {0};
+
+	// Act, the length is rejected before the source is read
+	expr = CalcCompile("1", (size_t)UINT32_MAX, &error);
+
+	// Assert
+	TEST_ASSERT_NULL(expr);
+	TEST_ASSERT_EQUAL_STRING("Expression too long", error.message);
+}
+
+void TEST_CalcEvaluate_RebindBetweenEvaluations_NewResults(void)
+{
+	// Arrange
+	expr = ArrangeCompiled("x^2 + y");
+	int x = CalcVariableSlot(expr, "x");
+	int y = CalcVariableSlot(expr, "y");
+	CalcBind(expr, y, 1);
+
+	// Act, Assert
+	for (int i = 0; i < 10; ++i)
+	{
+		CalcBind(expr, x, i);
+		TEST_ASSERT_EQUAL_DOUBLE(i*i + 1, CalcEvaluate(expr));
+	}
+}
+
+void TEST_CalcEvaluateWith_CallerVariables_HandleUntouched(void)
+{
+	// Arrange
+	expr = ArrangeCompiled("total = total + step");
+	double variables[2] = {40, 2};
+
+	// Act
+	double result = CalcEvaluateWith(expr, variables);
+
+	// Assert
+	TEST_ASSERT_EQUAL_DOUBLE(42, result);
+	TEST_ASSERT_EQUAL_DOUBLE(42, variables[0]);
+	TEST_ASSERT_EQUAL_DOUBLE(0, CalcEvaluate(expr));
+}
+
+void TEST_CalcEvaluate_MillionTermSum_Expected(void)
+{
+	// Arrange
+	const int count = 1000000;
+	char *input = malloc(2*count);
+	for (int i = 0; i < count; ++i) memcpy(input + 2*i, "x+", 2);
+	expr = CalcCompile(input, 2*count - 1, NULL);
+	free(input);
+	CalcBind(expr, CalcVariableSlot(expr, "x"), 0.5);
+
+	// Act
+	double actual = CalcEvaluate(expr);
+
+	// Assert
+	TEST_ASSERT_EQUAL_DOUBLE(count * 0.5, actual);
+}
+
+int main(void)
+{
+	UNITY_BEGIN();
+	RUN_TEST(TEST_CalcCompile_SourceWithVariables_SlotsInOrderOfAppearance);
+	RUN_TEST(TEST_CalcCompile_SyntaxError_NullWithErrorLocation);
+	RUN_TEST(TEST_CalcCompile_EmptySource_Null);
+	RUN_TEST(TEST_CalcCompile_LongerThanTokenOffsets_NullWithError);
+	RUN_TEST(TEST_CalcEvaluate_RebindBetweenEvaluations_NewResults);
+	RUN_TEST(TEST_CalcEvaluateWith_CallerVariables_HandleUntouched);
+	RUN_TEST(TEST_CalcEvaluate_MillionTermSum_Expected);
+	return UNITY_END();
+}
\ No newline at end of file
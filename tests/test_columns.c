@@ -0,0 +1,138 @@
+#include <stdlib.h>
+
+#include "unity.h"
+#include "unity_internals.h"
+#include "../src/tokenizer.h"
+#include "../src/parser.h"
+#include "../src/bytecode.h"
+#include "../src/columns.h"
+
+// Not a multiple of the block size, nor of any vector width.
+#define ROW_COUNT 1003
+
+static Parser parser;
+static Program program;
+static double x[ROW_COUNT];
+static double y[ROW_COUNT];
+static double results[ROW_COUNT];
+
+void setUp()
+{
+	unsigned seed = 12345;
+	for (int row = 0; row < ROW_COUNT; ++row)
+	{
+		seed = seed * 1103515245 + 12345;
+		x[row] = (double)(seed >> 8) / (1 << 20) - 4;
+		y[row] = row * 0.25;
+	}
+}
+
+void tearDown()
+{
+	ColumnsUseKernel(COLUMNS_KERNEL_AVX2);
+	ProgramFree(&program);
+	ParserRelease(&parser);
+}
+
+static void ArrangeProgram(const char *cstr)
+{
+	TokenStream ts = TokenStreamFromCStr(cstr);
+	ParserInit(&parser, &ts);
+	program = CompileExpr(ParseExpression(&parser, 0, (Token){TOK_INPUT_END}));
+}
+
+static void AssertSameAsRunProgram(const double *const *columns)
+{
+	for (int row = 0; row < ROW_COUNT; ++row)
+	{
+		double variables[3] = {0};
+		for (int slot = 0; slot < program.variableCount; ++slot)
+		{
+			variables[slot] = columns[slot] ? columns[slot][row] : 0;
+		}
+
+		TEST_ASSERT_EQUAL_DOUBLE(RunProgram(&program, variables), results[row]);
+	}
+}
+
+void TEST_RunProgramColumns_AllKernels_SameAsRunProgramPerRow(void)
+{
+	// Arrange
+	ArrangeProgram("-(x - 1.5) * y / (x*x + 1) + 2^-x - -y");
+	const double *columns[] = {x, y};
+
+	for (ColumnsKernel kernel = COLUMNS_KERNEL_SCALAR; kernel <= COLUMNS_KERNEL_AVX2; ++kernel)
+	{
+		if (ColumnsUseKernel(kernel) != kernel) continue;
+
+		// Act
+		RunProgramColumns(&program, columns, results, ROW_COUNT);
+
+		// Assert
+		AssertSameAsRunProgram(columns);
+	}
+}
+
+void TEST_RunProgramColumns_AssignmentInRow_LaterReadsSeeAssignedValue(void)
+{
+	// Arrange
+	ArrangeProgram("(y = x * 2) + y");
+	const double *columns[] = {y, x};
+
+	// Act
+	RunProgramColumns(&program, columns, results, ROW_COUNT);
+
+	// Assert
+	for (int row = 0; row < ROW_COUNT; ++row)
+	{
+		TEST_ASSERT_EQUAL_DOUBLE(4 * x[row], results[row]);
+	}
+	TEST_ASSERT_EQUAL_DOUBLE((ROW_COUNT - 1) * 0.25, y[ROW_COUNT - 1]);
+}
+
+void TEST_RunProgramColumns_NullColumn_ReadsAsZero(void)
+{
+	// Arrange
+	ArrangeProgram("x + unbound");
+	const double *columns[] = {x, NULL};
+
+	// Act
+	RunProgramColumns(&program, columns, results, ROW_COUNT);
+
+	// Assert
+	AssertSameAsRunProgram(columns);
+	TEST_ASSERT_EQUAL_DOUBLE(x[7], results[7]);
+}
+
+void TEST_RunProgramColumns_ConstantPowers_SameAsRunProgramPerRow(void)
+{
+	// Arrange
+	ArrangeProgram("x^2 - y^0.5 + x^-3 * y^1.5 + x^7.5 - y^0 + x^-0.5");
+	const double *columns[] = {x, y};
+
+	for (ColumnsKernel kernel = COLUMNS_KERNEL_SCALAR; kernel <= COLUMNS_KERNEL_AVX2; ++kernel)
+	{
+		if (ColumnsUseKernel(kernel) != kernel) continue;
+
+		// Act
+		RunProgramColumns(&program, columns, results, ROW_COUNT);
+
+		// Assert
+		for (int row = 0; row < ROW_COUNT; ++row)
+		{
+			double variables[2] = {x[row], y[row]};
+			double expected = RunProgram(&program, variables);
+			TEST_ASSERT_EQUAL_MEMORY(&expected, &results[row], sizeof(double));
+		}
+	}
+}
+
+int main(void)
+{
+	UNITY_BEGIN();
+	RUN_TEST(TEST_RunProgramColumns_AllKernels_SameAsRunProgramPerRow);
+	RUN_TEST(TEST_RunProgramColumns_AssignmentInRow_LaterReadsSeeAssignedValue);
+	RUN_TEST(TEST_RunProgramColumns_NullColumn_ReadsAsZero);
+	RUN_TEST(TEST_RunProgramColumns_ConstantPowers_SameAsRunProgramPerRow);
+	return UNITY_END();
+}
\ No newline at end of file
@@ -0,0 +1,159 @@
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity.h"
+#include "unity_internals.h"
+#include "../src/decimal.h"
+
+void setUp(){}
+void tearDown(){}
+
+static double ParseCStr(const char *cstr)
+{
+	return ParseDecimal(cstr, cstr + strlen(cstr));
+}
+
+static void AssertSameAsStrtod(const char *literal)
+{
+	double expected = strtod(literal, NULL);
+	double actual = ParseCStr(literal);
+
+	if (memcmp(&expected, &actual, sizeof(double)) != 0)
+	{
+		char message[128];
+		snprintf(message, sizeof(message), "Literal %.60s%s", literal, strlen(literal) > 60 ? "..." : "");
+		TEST_FAIL_MESSAGE(message);
+	}
+}
+
+void TEST_ParseDecimal_SimpleLiterals_ExpectedValues(void)
+{
+	// Arrange, Act, Assert
+	TEST_ASSERT_EQUAL_DOUBLE(0.0, ParseCStr("0"));
+	TEST_ASSERT_EQUAL_DOUBLE(42.0, ParseCStr("42"));
+	TEST_ASSERT_EQUAL_DOUBLE(3.14159, ParseCStr("3.14159"));
+	TEST_ASSERT_EQUAL_DOUBLE(0.00000000000000000016, ParseCStr("0.00000000000000000016"));
+	TEST_ASSERT_EQUAL_DOUBLE(6022.0, ParseCStr("6022."));
+}
+
+void TEST_ParseDecimal_LiteralLongerThan128Chars_NotTruncated(void)
+{
+	// Arrange
+	char literal[301];
+	memset(literal, '0', 300);
+	literal[0] = '1';
+	literal[300] = '\0';
+
+	// Act
+	double actual = ParseCStr(literal);
+
+	// Assert
+	TEST_ASSERT_EQUAL_DOUBLE(1e299, actual);
+}
+
+void TEST_ParseDecimal_HalfwayCases_RoundToEven(void)
+{
+	// 2^53 + 1 is halfway between 2^53 and 2^53 + 2.
+	AssertSameAsStrtod("9007199254740993");
+	// 1 + 2^-53 is halfway between 1 and the next double.
+	AssertSameAsStrtod("1.00000000000000011102230246251565404236316680908203125");
+	// Just above that halfway point.
+	AssertSameAsStrtod("1.000000000000000111022302462515654042363166809082031250000000000000000000001");
+	// Just below it.
+	AssertSameAsStrtod("1.000000000000000111022302462515654042363166809082031249999999999999999999999");
+}
+
+void TEST_ParseDecimal_ExtremeMagnitudes_SameAsStrtod(void)
+{
+	char literal[1200];
+
+	// Smallest subnormal, written out in full.
+	snprintf(literal, sizeof(literal), "%.1100f", 4.9406564584124654e-324);
+	AssertSameAsStrtod(literal);
+
+	// Far below the smallest subnormal.
+	memset(literal, '0', 1100);
+	literal[0] = '0';
+	literal[1] = '.';
+	literal[1099] = '7';
+	literal[1100] = '\0';
+	AssertSameAsStrtod(literal);
+
+	// Largest double, and overflow to infinity.
+	snprintf(literal, sizeof(literal), "%.0f", DBL_MAX);
+	AssertSameAsStrtod(literal);
+	literal[0] = '9';
+	AssertSameAsStrtod(literal);
+}
+
+void TEST_ParseDecimal_RandomLiterals_SameAsStrtod(void)
+{
+	srand(12345);
+
+	for (int i = 0; i < 200000; ++i)
+	{
+		char literal[128];
+		int len = 0;
+
+		int intDigits = rand() % 26;
+		int fracDigits = rand() % 31;
+		if (intDigits == 0) intDigits = 1;
+
+		for (int d = 0; d < intDigits; ++d) literal[len++] = (char)('0' + rand() % 10);
+		if (fracDigits)
+		{
+			literal[len++] = '.';
+			for (int d = 0; d < fracDigits; ++d) literal[len++] = (char)('0' + rand() % 10);
+		}
+		literal[len] = '\0';
+
+		AssertSameAsStrtod(literal);
+	}
+}
+
+void TEST_ParseDecimal_NearHalfwayBetweenRandomDoubles_SameAsStrtod(void)
+{
+	if (LDBL_MANT_DIG <= DBL_MANT_DIG) TEST_IGNORE_MESSAGE("long double cannot hold a halfway point");
+
+	srand(54321);
+
+	for (int i = 0; i < 5000; ++i)
+	{
+		double a = ldexp((double)rand() / RAND_MAX + 0.5, rand() % 200 - 100);
+		double b = nextafter(a, INFINITY);
+		long double halfway = ((long double)a + (long double)b) / 2;
+
+		char literal[1024];
+		int len = snprintf(literal, sizeof(literal), "%.700Lf", halfway);
+		while (literal[len - 1] == '0') literal[--len] = '\0';
+		if (literal[len - 1] == '.') literal[--len] = '\0';
+
+		AssertSameAsStrtod(literal);
+
+		// Nudge the last digit down and up.
+		if (literal[len - 1] > '0')
+		{
+			literal[len - 1] = (char)(literal[len - 1] - 1);
+			AssertSameAsStrtod(literal);
+			literal[len - 1] = (char)(literal[len - 1] + 1);
+		}
+		literal[len++] = '1';
+		literal[len] = '\0';
+		AssertSameAsStrtod(literal);
+	}
+}
+
+int main(void)
+{
+	UNITY_BEGIN();
+	RUN_TEST(TEST_ParseDecimal_SimpleLiterals_ExpectedValues);
+	RUN_TEST(TEST_ParseDecimal_LiteralLongerThan128Chars_NotTruncated);
+	RUN_TEST(TEST_ParseDecimal_HalfwayCases_RoundToEven);
+	RUN_TEST(TEST_ParseDecimal_ExtremeMagnitudes_SameAsStrtod);
+	RUN_TEST(TEST_ParseDecimal_RandomLiterals_SameAsStrtod);
+	RUN_TEST(TEST_ParseDecimal_NearHalfwayBetweenRandomDoubles_SameAsStrtod);
+	return UNITY_END();
+}
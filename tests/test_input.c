@@ -0,0 +1,175 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity.h"
+#include "unity_internals.h"
+#include "../src/input.h"
+
+static FILE *file;
+static LineReader reader;
+
+void setUp()
+{
+	file = tmpfile();
+}
+
+void tearDown()
+{
+	LineReaderFree(&reader);
+	fclose(file);
+}
+
+static void ArrangeFile(const char *contents, size_t len)
+{
+	fwrite(contents, 1, len, file);
+	fflush(file);
+	rewind(file);
+}
+
+void TEST_ReadEntireFile_TmpFile_ContentsNullTerminated(void)
+{
+	// Arrange
+	ArrangeFile("1 + 2\n", 6);
+	char *contents;
+	size_t contentsLen;
+
+	// Act
+	int result = ReadEntireFile(file, &contents, &contentsLen);
+
+	// Assert
+	TEST_ASSERT_EQUAL_INT32(0, result);
+	TEST_ASSERT_EQUAL_UINT64(6, contentsLen);
+	TEST_ASSERT_EQUAL_STRING("1 + 2\n", contents);
+	free(contents);
+}
+
+void TEST_MapFile_RegularFile_MappedContents(void)
+{
+	// Arrange
+	ArrangeFile("2 ^ 10\n", 7);
+	MappedFile mapped;
+
+	// Act
+	bool isMapped = MapFile(file, &mapped);
+
+	// Assert
+	TEST_ASSERT_TRUE(isMapped);
+	TEST_ASSERT_EQUAL_UINT64(7, mapped.len);
+	TEST_ASSERT_EQUAL_MEMORY("2 ^ 10\n", mapped.data, 7);
+	UnmapFile(&mapped);
+}
+
+void TEST_MapFile_EmptyFile_EmptyMapping(void)
+{
+	// Arrange
+	MappedFile mapped;
+
+	// Act
+	bool isMapped = MapFile(file, &mapped);
+
+	// Assert
+	TEST_ASSERT_TRUE(isMapped);
+	TEST_ASSERT_EQUAL_UINT64(0, mapped.len);
+	UnmapFile(&mapped);
+}
+
+void TEST_ReadLine_LastLineWithoutNewline_AllLines(void)
+{
+	// Arrange
+	ArrangeFile("1\n\n2 + 3", 8);
+	reader = LineReaderFromFile(file);
+	const char *line;
+	size_t lineLen;
+
+	// Act, Assert
+	TEST_ASSERT_TRUE(ReadLine(&reader, &line, &lineLen));
+	TEST_ASSERT_EQUAL_UINT64(1, lineLen);
+	TEST_ASSERT_EQUAL_MEMORY("1", line, 1);
+
+	TEST_ASSERT_TRUE(ReadLine(&reader, &line, &lineLen));
+	TEST_ASSERT_EQUAL_UINT64(0, lineLen);
+
+	TEST_ASSERT_TRUE(ReadLine(&reader, &line, &lineLen));
+	TEST_ASSERT_EQUAL_UINT64(5, lineLen);
+	TEST_ASSERT_EQUAL_MEMORY("2 + 3", line, 5);
+
+	TEST_ASSERT_FALSE(ReadLine(&reader, &line, &lineLen));
+	TEST_ASSERT_FALSE(reader.failed);
+}
+
+void TEST_ReadLine_ManyLinesAcrossChunks_BufferStaysSmall(void)
+{
+	// Arrange
+	const char *text = "12345.678 * 9\n";
+	size_t textLen = strlen(text);
+	for (int i = 0; i < 100000; ++i) fwrite(text, 1, textLen, file);
+	fflush(file);
+	rewind(file);
+	reader = LineReaderFromFile(file);
+	const char *line;
+	size_t lineLen;
+	int lineCount = 0;
+
+	// Act
+	while (ReadLine(&reader, &line, &lineLen))
+	{
+		TEST_ASSERT_EQUAL_UINT64(textLen - 1, lineLen);
+		TEST_ASSERT_EQUAL_MEMORY(text, line, lineLen);
+		++lineCount;
+	}
+
+	// Assert
+	TEST_ASSERT_EQUAL_INT32(100000, lineCount);
+	TEST_ASSERT_TRUE(reader.capacity < textLen * 100000 / 4);
+}
+
+void TEST_ReadLine_LineLongerThanBuffer_WholeLine(void)
+{
+	// Arrange
+	size_t longLen = 300000;
+	char *longLine = malloc(longLen + 1);
+	memset(longLine, '1', longLen);
+	longLine[longLen] = '\n';
+	ArrangeFile(longLine, longLen + 1);
+	reader = LineReaderFromFile(file);
+	const char *line;
+	size_t lineLen;
+
+	// Act
+	bool gotLine = ReadLine(&reader, &line, &lineLen);
+
+	// Assert
+	TEST_ASSERT_TRUE(gotLine);
+	TEST_ASSERT_EQUAL_UINT64(longLen, lineLen);
+	TEST_ASSERT_FALSE(ReadLine(&reader, &line, &lineLen));
+	free(longLine);
+}
+
+void TEST_ReadLine_FromBuffer_SplitsLines(void)
+{
+	// Arrange
+	reader = LineReaderFromBuffer("a\nb\n", 4);
+	const char *line;
+	size_t lineLen;
+
+	// Act, Assert
+	TEST_ASSERT_TRUE(ReadLine(&reader, &line, &lineLen));
+	TEST_ASSERT_EQUAL_MEMORY("a", line, 1);
+	TEST_ASSERT_TRUE(ReadLine(&reader, &line, &lineLen));
+	TEST_ASSERT_EQUAL_MEMORY("b", line, 1);
+	TEST_ASSERT_FALSE(ReadLine(&reader, &line, &lineLen));
+}
+
+int main(void)
+{
+	UNITY_BEGIN();
+	RUN_TEST(TEST_ReadEntireFile_TmpFile_ContentsNullTerminated);
+	RUN_TEST(TEST_MapFile_RegularFile_MappedContents);
+	RUN_TEST(TEST_MapFile_EmptyFile_EmptyMapping);
+	RUN_TEST(TEST_ReadLine_LastLineWithoutNewline_AllLines);
+	RUN_TEST(TEST_ReadLine_ManyLinesAcrossChunks_BufferStaysSmall);
+	RUN_TEST(TEST_ReadLine_LineLongerThanBuffer_WholeLine);
+	RUN_TEST(TEST_ReadLine_FromBuffer_SplitsLines);
+	return UNITY_END();
+}
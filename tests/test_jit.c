@@ -0,0 +1,231 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity.h"
+#include "unity_internals.h"
+#include "../src/tokenizer.h"
+#include "../src/parser.h"
+#include "../src/jit.h"
+
+static Parser parser;
+static JitCode code;
+
+void setUp() {}
+void tearDown()
+{
+	JitFree(&code);
+	ParserRelease(&parser);
+}
+
+static Expr *ArrangeExpr(const char *cstr)
+{
+	TokenStream ts = TokenStreamFromCStr(cstr);
+	ParserInit(&parser, &ts);
+	return ParseExpression(&parser, 0, (Token){TOK_INPUT_END});
+}
+
+// Compiles the expression, skipping the test where there is no JIT.
+static void ArrangeJit(Expr *expr)
+{
+	if (!JitCompile(expr, &code)) TEST_IGNORE_MESSAGE("No JIT on this platform");
+}
+
+void TEST_JitCompile_Arithmetic_SameAsEvalExpr(void)
+{
+	// Arrange
+	Expr *expr = ArrangeExpr("(1 + 2*(3 - 4^0))/7 - 5^2 + -(2^-1) * 3 - -0.5");
+	ArrangeJit(expr);
+
+	// Act
+	double actual = code.fn(NULL);
+
+	// Assert
+	TEST_ASSERT_EQUAL_DOUBLE(EvalExpr(expr, NULL), actual);
+}
+
+void TEST_JitCompile_VariablesAndAssignments_SameAsEvalExpr(void)
+{
+	// Arrange
+	Expr *expr = ArrangeExpr("-(a = b^2 - c) * (d = -a / (b + 1)) + a^d - -c");
+	ArrangeJit(expr);
+	double treeVariables[4] = {0, 1.5, 0.25, 0};
+	double jitVariables[4] = {0, 1.5, 0.25, 0};
+
+	// Act
+	double actual = code.fn(jitVariables);
+
+	// Assert
+	TEST_ASSERT_EQUAL_DOUBLE(EvalExpr(expr, treeVariables), actual);
+	TEST_ASSERT_EQUAL_MEMORY(treeVariables, jitVariables, sizeof(treeVariables));
+}
+
+void TEST_JitCompile_DeepRightNesting_SpillsAndSameAsEvalExpr(void)
+{
+	// Arrange
+	char input[2048] = {0};
+	int len = 0;
+	for (int i = 0; i < 100; ++i) len += sprintf(input + len, "%d %c (", i % 5 + 1, "+-*/^"[i % 5]);
+	len += sprintf(input + len, "x");
+	memset(input + len, ')', 100);
+
+	Expr *expr = ArrangeExpr(input);
+	ArrangeJit(expr);
+	double variables[1] = {1.25};
+
+	// Act
+	double actual = code.fn(variables);
+
+	// Assert
+	TEST_ASSERT_EQUAL_DOUBLE(EvalExpr(expr, variables), actual);
+}
+
+void TEST_JitCompile_NegativeZeroConstant_KeptApartFromZero(void)
+{
+	// Arrange
+	Expr *expr = ArrangeExpr("1 / -0 + 0");
+	ArrangeJit(expr);
+
+	// Act
+	double actual = code.fn(NULL);
+
+	// Assert
+	TEST_ASSERT_EQUAL_DOUBLE(EvalExpr(expr, NULL), actual);
+	TEST_ASSERT_TRUE(actual < 0);
+}
+
+void TEST_JitCompile_RandomExpressions_SameAsEvalExpr(void)
+{
+	unsigned seed = 2024;
+
+	for (int round = 0; round < 200; ++round)
+	{
+		// Arrange
+		char input[512];
+		int len = 0;
+		for (int term = 0; term < 12; ++term)
+		{
+			seed = seed * 1103515245 + 12345;
+			unsigned r = seed >> 8;
+			if (term > 0) len += sprintf(input + len, " %c ", "+-*/^"[r % 5]);
+			if (r % 7 == 0) len += sprintf(input + len, "-");
+			if (r % 3 == 0) len += sprintf(input + len, "%c", "xyz"[r % 3 + (r >> 4) % 2]);
+			else len += sprintf(input + len, "(%u.%u - y)", r % 9, (r >> 6) % 100);
+		}
+
+		Expr *expr = ArrangeExpr(input);
+		ArrangeJit(expr);
+		double variables[3] = {1.5, -0.75, 2};
+
+		// Act
+		double actual = code.fn(variables);
+
+		// Assert
+		double expected = EvalExpr(expr, variables);
+		TEST_ASSERT_EQUAL_MEMORY_MESSAGE(&expected, &actual, sizeof(double), input);
+
+		JitFree(&code);
+		ParserRelease(&parser);
+	}
+}
+
+void TEST_JitCompile_ConstantPowers_SameAsEvalExpr(void)
+{
+	// Arrange
+	char input[64];
+	double bases[] = {0.7, -1.3, 2, 1e10, 0};
+
+	for (int halves = -POW_HALVES_MAX; halves <= POW_HALVES_MAX; ++halves)
+	{
+		sprintf(input, "-(x = x)^%g", halves / 2.0);
+		Expr *expr = ArrangeExpr(input);
+		ArrangeJit(expr);
+
+		for (int i = 0; i < (int)(sizeof(bases)/sizeof(*bases)); ++i)
+		{
+			double variables[1] = {bases[i]};
+
+			// Act
+			double actual = code.fn(variables);
+
+			// Assert
+			double expected = EvalExpr(expr, variables);
+			TEST_ASSERT_EQUAL_MEMORY_MESSAGE(&expected, &actual, sizeof(double), input);
+		}
+
+		JitFree(&code);
+		ParserRelease(&parser);
+	}
+}
+
+void TEST_JitCompile_ManyDistinctConstants_SameAsEvalExpr(void)
+{
+	// Arrange, every literal twice, so half of them are looked up again
+	const int count = 200000;
+	char *input = malloc(16*count);
+	int len = 0;
+	for (int i = 0; i < count; ++i) len += sprintf(input + len, "%d.25+", i % (count/2));
+	input[len - 1] = '\0';
+	Expr *expr = ArrangeExpr(input);
+	free(input);
+	ArrangeJit(expr);
+
+	// Act
+	double actual = code.fn(NULL);
+
+	// Assert
+	TEST_ASSERT_EQUAL_DOUBLE(EvalExpr(expr, NULL), actual);
+}
+
+void TEST_JitCompile_MillionTermSum_Expected(void)
+{
+	// Arrange
+	const int count = 1000000;
+	char *input = malloc(10*count);
+	int len = 0;
+	for (int i = 0; i < count; ++i) len += sprintf(input + len, "%d.5+", i);
+	input[len - 1] = '\0';
+	ArrangeJit(ArrangeExpr(input));
+	free(input);
+
+	// Act
+	double actual = code.fn(NULL);
+
+	// Assert, every literal distinct; the partial sums are exact
+	TEST_ASSERT_EQUAL_DOUBLE(0.5 * count * count, actual);
+}
+
+void TEST_JitCompile_RightNestingDeeperThanFrame_NotCompiled(void)
+{
+	// Arrange
+	const int count = 100000;
+	char *input = malloc(4*count + 2);
+	for (int i = 0; i < count; ++i) memcpy(input + 3*i, "(x-", 3);
+	input[3*count] = 'x';
+	memset(input + 3*count + 1, ')', count);
+	input[4*count + 1] = '\0';
+	Expr *expr = ArrangeExpr(input);
+	free(input);
+
+	// Act
+	bool compiled = JitCompile(expr, &code);
+
+	// Assert
+	TEST_ASSERT_FALSE(compiled);
+	TEST_ASSERT_NULL(code.fn);
+}
+
+int main(void)
+{
+	UNITY_BEGIN();
+	RUN_TEST(TEST_JitCompile_Arithmetic_SameAsEvalExpr);
+	RUN_TEST(TEST_JitCompile_VariablesAndAssignments_SameAsEvalExpr);
+	RUN_TEST(TEST_JitCompile_DeepRightNesting_SpillsAndSameAsEvalExpr);
+	RUN_TEST(TEST_JitCompile_NegativeZeroConstant_KeptApartFromZero);
+	RUN_TEST(TEST_JitCompile_RandomExpressions_SameAsEvalExpr);
+	RUN_TEST(TEST_JitCompile_ConstantPowers_SameAsEvalExpr);
+	RUN_TEST(TEST_JitCompile_ManyDistinctConstants_SameAsEvalExpr);
+	RUN_TEST(TEST_JitCompile_MillionTermSum_Expected);
+	RUN_TEST(TEST_JitCompile_RightNestingDeeperThanFrame_NotCompiled);
+	return UNITY_END();
+}
\ No newline at end of file
@@ -0,0 +1,171 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity.h"
+#include "unity_internals.h"
+#include "../src/tokenizer.h"
+#include "../src/parser.h"
+#include "../src/optimize.h"
+
+static Parser parser;
+
+void setUp() {}
+void tearDown()
+{
+	ParserRelease(&parser);
+}
+
+static Expr *ArrangeExpr(const char *cstr)
+{
+	TokenStream ts = TokenStreamFromCStr(cstr);
+	ParserInit(&parser, &ts);
+	return ParseExpression(&parser, 0, (Token){TOK_INPUT_END});
+}
+
+void TEST_OptimizeExpr_ConstantPrefix_FoldedIntoOneNumber(void)
+{
+	// Arrange
+	Expr *expr = ArrangeExpr("2*3.14159*r");
+
+	// Act
+	int before = CountExprNodes(expr);
+	expr = OptimizeExpr(expr);
+
+	// Assert
+	TEST_ASSERT_EQUAL_INT32(5, before);
+	TEST_ASSERT_EQUAL_INT32(3, CountExprNodes(expr));
+	TEST_ASSERT_EQUAL_INT32(EXPR_NUMBER, expr->as.binop.lhs->type);
+	TEST_ASSERT_EQUAL_DOUBLE(2*3.14159, expr->as.binop.lhs->as.number);
+}
+
+void TEST_OptimizeExpr_Identities_OnlyVariableLeft(void)
+{
+	// Arrange
+	Expr *expr = ArrangeExpr("(x*1 + 0)/1 - 0 + (1 - 1)*y^0");
+
+	// Act
+	expr = OptimizeExpr(expr);
+
+	// Assert
+	TEST_ASSERT_EQUAL_INT32(EXPR_VARIABLE, expr->type);
+	TEST_ASSERT_EQUAL_INT32(0, expr->flags);
+}
+
+void TEST_OptimizeExpr_NegationsAcrossProduct_OneLeftAtRoot(void)
+{
+	// Arrange
+	Expr *expr = ArrangeExpr("-(-a * -(b / -c)) * -1");
+	ExprFlags expectedFlags = EXPR_FLAG_NEGATED;
+
+	// Act
+	expr = OptimizeExpr(expr);
+
+	// Assert
+	TEST_ASSERT_EQUAL_INT32(5, CountExprNodes(expr));
+	TEST_ASSERT_EQUAL_INT32(expectedFlags, expr->flags);
+	TEST_ASSERT_EQUAL_INT32(0, expr->as.binop.lhs->flags);
+	TEST_ASSERT_EQUAL_INT32(0, expr->as.binop.rhs->flags);
+}
+
+void TEST_OptimizeExpr_PlusNegated_BecomesMinus(void)
+{
+	// Arrange
+	Expr *expr = ArrangeExpr("a + -b");
+
+	// Act
+	expr = OptimizeExpr(expr);
+
+	// Assert
+	TEST_ASSERT_EQUAL_INT32(OP_MINUS, expr->as.binop.op);
+	TEST_ASSERT_EQUAL_INT32(0, expr->as.binop.rhs->flags);
+}
+
+void TEST_OptimizeExpr_AssignmentRaisedToZero_AssignmentKept(void)
+{
+	// Arrange
+	double variables[1] = {0};
+	Expr *expr = ArrangeExpr("(y = 3)^0 + 0");
+
+	// Act
+	expr = OptimizeExpr(expr);
+	double result = EvalExpr(expr, variables);
+
+	// Assert
+	TEST_ASSERT_EQUAL_DOUBLE(1, result);
+	TEST_ASSERT_EQUAL_DOUBLE(3, variables[0]);
+}
+
+void TEST_OptimizeExpr_RandomExpressions_SameValue(void)
+{
+	unsigned seed = 77;
+
+	for (int round = 0; round < 300; ++round)
+	{
+		// Arrange
+		char input[512];
+		int len = 0;
+		for (int term = 0; term < 10; ++term)
+		{
+			seed = seed * 1103515245 + 12345;
+			unsigned r = seed >> 8;
+			if (term > 0) len += sprintf(input + len, " %c ", "+-*/^"[r % 5]);
+			if (r % 3 == 0) len += sprintf(input + len, "-");
+			switch ((r >> 4) % 4)
+			{
+				case 0: len += sprintf(input + len, "%c", "xy"[(r >> 6) % 2]); break;
+				case 1: len += sprintf(input + len, "%u", (r >> 6) % 3); break;
+				case 2: len += sprintf(input + len, "(%u.5 * -x)", (r >> 6) % 4); break;
+				default: len += sprintf(input + len, "(-1 * y - 0)"); break;
+			}
+		}
+
+		double variables[2] = {1.75, -0.5};
+		double expected = EvalExpr(ArrangeExpr(input), variables);
+		ParserRelease(&parser);
+
+		Expr *expr = ArrangeExpr(input);
+
+		// Act
+		double actual = EvalExpr(OptimizeExpr(expr), variables);
+
+		// Assert
+		if (isnan(expected)) TEST_ASSERT_TRUE_MESSAGE(isnan(actual), input);
+		else TEST_ASSERT_EQUAL_DOUBLE_MESSAGE(expected, actual, input);
+
+		ParserRelease(&parser);
+	}
+}
+
+void TEST_OptimizeExpr_MillionTermSum_IdentitiesRemoved(void)
+{
+	// Arrange
+	const int count = 1000000;
+	char *input = malloc(4*count);
+	for (int i = 0; i < count; ++i) memcpy(input + 4*i, "x*1+", 4);
+	input[4*count - 1] = '\0';
+	Expr *expr = ArrangeExpr(input);
+	free(input);
+	double variables[1] = {0.5};
+
+	// Act
+	expr = OptimizeExpr(expr);
+
+	// Assert
+	TEST_ASSERT_EQUAL_INT32(2*count - 1, CountExprNodes(expr));
+	TEST_ASSERT_EQUAL_DOUBLE(count * 0.5, EvalExpr(expr, variables));
+}
+
+int main(void)
+{
+	UNITY_BEGIN();
+	RUN_TEST(TEST_OptimizeExpr_ConstantPrefix_FoldedIntoOneNumber);
+	RUN_TEST(TEST_OptimizeExpr_Identities_OnlyVariableLeft);
+	RUN_TEST(TEST_OptimizeExpr_NegationsAcrossProduct_OneLeftAtRoot);
+	RUN_TEST(TEST_OptimizeExpr_PlusNegated_BecomesMinus);
+	RUN_TEST(TEST_OptimizeExpr_AssignmentRaisedToZero_AssignmentKept);
+	RUN_TEST(TEST_OptimizeExpr_RandomExpressions_SameValue);
+	RUN_TEST(TEST_OptimizeExpr_MillionTermSum_IdentitiesRemoved);
+	return UNITY_END();
+}
\ No newline at end of file
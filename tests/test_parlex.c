@@ -0,0 +1,149 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity.h"
+#include "unity_internals.h"
+#include "../src/parlex.h"
+
+static ThreadPool pool;
+static Scope expectedScope;
+static Scope actualScope;
+static TokenBuffer expected;
+static TokenBuffer actual;
+
+void setUp()
+{
+	TEST_ASSERT_TRUE(PoolInit(&pool, 4));
+}
+
+void tearDown()
+{
+	TokenBufferFree(&expected);
+	TokenBufferFree(&actual);
+	ScopeFree(&expectedScope);
+	ScopeFree(&actualScope);
+	PoolRelease(&pool);
+}
+
+// Lines of numbers, names and operators, with names coming back across
+// lines so chunks share some.
+static char *GenerateLines(size_t minBytes)
+{
+	size_t capacity = minBytes + 256;
+	char *result = malloc(capacity);
+	size_t len = 0;
+	unsigned seed = 1;
+
+	while (len < minBytes)
+	{
+		seed = seed * 1103515245 + 12345;
+		unsigned r = seed >> 8;
+		len += snprintf(result + len, capacity - len, "%*s(x%u + %u.%u) * name_%u ^\t2 -\n",
+			(int)(r % 7), "", r % 50, r % 1000, r % 10, (r >> 4) % 5000);
+	}
+
+	memcpy(result + len, "1", 2);
+	return result;
+}
+
+static void AssertSameTokens(void)
+{
+	TEST_ASSERT_EQUAL_UINT64(expected.count, actual.count);
+	TEST_ASSERT_EQUAL_MEMORY(expected.tokens, actual.tokens, expected.count * sizeof(*expected.tokens));
+
+	TEST_ASSERT_EQUAL_UINT64(expected.numberCount, actual.numberCount);
+	TEST_ASSERT_EQUAL_MEMORY(expected.numbers, actual.numbers, expected.numberCount * sizeof(*expected.numbers));
+
+	TEST_ASSERT_EQUAL_UINT64(expected.identCount, actual.identCount);
+	TEST_ASSERT_EQUAL_MEMORY(expected.idents, actual.idents, expected.identCount * sizeof(*expected.idents));
+
+	TEST_ASSERT_EQUAL_INT32(expectedScope.count, actualScope.count);
+	for (int i = 0; i < expectedScope.count; ++i)
+	{
+		TEST_ASSERT_EQUAL_UINT64(expectedScope.names[i].len, actualScope.names[i].len);
+		TEST_ASSERT_EQUAL_STRING_LEN(expectedScope.names[i].chars, actualScope.names[i].chars, expectedScope.names[i].len);
+	}
+}
+
+static void ArrangeAndAct(const char *input, size_t len, bool identViews)
+{
+	TokenStream sequential = TokenStreamFromBuffer(input, len);
+	sequential.scope = &expectedScope;
+	sequential.identViews = identViews;
+	LexTokens(&sequential, &expected);
+
+	TokenStream parallel = TokenStreamFromBuffer(input, len);
+	parallel.scope = &actualScope;
+	parallel.identViews = identViews;
+	LexTokensParallel(&parallel, &actual, &pool);
+
+	TEST_ASSERT_EQUAL_PTR(sequential.at, parallel.at);
+}
+
+void TEST_LexTokensParallel_ManyLines_SameAsLexTokens(void)
+{
+	// Arrange
+	char *input = GenerateLines(16 * PARLEX_MIN_CHUNK_BYTES);
+
+	// Act
+	ArrangeAndAct(input, strlen(input), false);
+
+	// Assert
+	AssertSameTokens();
+
+	int line, column;
+	PackedToken last = actual.tokens[actual.count - 2];
+	TokenBufferLocation(&actual, last.offset, &line, &column);
+	TEST_ASSERT_EQUAL_INT32(TOK_NUMBER, last.type);
+	TEST_ASSERT_GREATER_THAN_INT32(100000, line);
+	TEST_ASSERT_EQUAL_INT32(0, column);
+
+	free(input);
+}
+
+void TEST_LexTokensParallel_ZeroByteInLaterChunk_EndsThereLikeLexTokens(void)
+{
+	// Arrange
+	size_t len = 16 * PARLEX_MIN_CHUNK_BYTES;
+	char *input = GenerateLines(len);
+	len = strlen(input);
+	input[len / 2] = '\0';
+
+	// Act
+	ArrangeAndAct(input, len, true);
+
+	// Assert
+	AssertSameTokens();
+	TEST_ASSERT_EQUAL_PTR(input + len / 2, input + actual.tokens[actual.count - 1].offset);
+
+	free(input);
+}
+
+void TEST_LexTokensParallel_NoNewlines_OneChunkSameAsLexTokens(void)
+{
+	// Arrange
+	size_t len = 4 * PARLEX_MIN_CHUNK_BYTES;
+	char *input = malloc(len + 1);
+	for (size_t i = 0; i < len; i += 4) memcpy(input + i, "a+1+", 4);
+	input[len - 1] = ' ';
+	input[len] = '\0';
+
+	// Act
+	ArrangeAndAct(input, len, true);
+
+	// Assert
+	AssertSameTokens();
+	TEST_ASSERT_EQUAL_UINT64(len, actual.count);
+
+	free(input);
+}
+
+int main(void)
+{
+	UNITY_BEGIN();
+	RUN_TEST(TEST_LexTokensParallel_ManyLines_SameAsLexTokens);
+	RUN_TEST(TEST_LexTokensParallel_ZeroByteInLaterChunk_EndsThereLikeLexTokens);
+	RUN_TEST(TEST_LexTokensParallel_NoNewlines_OneChunkSameAsLexTokens);
+	return UNITY_END();
+}
\ No newline at end of file
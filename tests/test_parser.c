@@ -1,19 +1,27 @@
 #include <assert.h>
 #include <math.h>
 #include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "unity.h"
 #include "unity_internals.h"
 #include "../src/tokenizer.h"
 #include "../src/parser.h"
 
+static Parser parser;
+
 void setUp() {}
-void tearDown(){}
+void tearDown()
+{
+	ParserRelease(&parser);
+}
 
 static Expr *ArrangeExpr(const char *cstr)
 {
 	TokenStream ts = TokenStreamFromCStr(cstr);
-	return ParseExpression(&ts, 0, (Token){TOK_INPUT_END});
+	ParserInit(&parser, &ts);
+	return ParseExpression(&parser, 0, (Token){TOK_INPUT_END});
 }
 
 void TEST_ParseExpression_EmptyInput_Null(void)
@@ -90,6 +98,33 @@ void TEST_ParseExpression_UnaryMinusOnExponent_ExponentNegated(void)
 	TEST_ASSERT_EQUAL_INT32(expectedFlags, expr->as.binop.rhs->flags);
 }
 
+void TEST_ParseExpression_MissingOperandOnSecondLine_ErrorAtInputEnd(void)
+{
+	// Arrange, Act
+	Expr *expr = ArrangeExpr("1 +\n  2 *");
+
+	// Assert
+	TEST_ASSERT_NOT_NULL(expr);
+	TEST_ASSERT_EQUAL_INT32(EXPR_PARSE_ERROR, expr->type);
+	TEST_ASSERT_EQUAL_INT32(1, expr->as.error.line);
+	TEST_ASSERT_EQUAL_INT32(5, expr->as.error.column);
+}
+
+void TEST_ParserReset_SecondInput_ParsesSecondInput(void)
+{
+	// Arrange
+	ArrangeExpr("1 + 2 + 3 + 4");
+	TokenStream ts = TokenStreamFromBuffer("2 * 21 trailing", 6);
+
+	// Act
+	ParserReset(&parser, &ts);
+	Expr *expr = ParseExpression(&parser, 0, (Token){TOK_INPUT_END});
+
+	// Assert
+	TEST_ASSERT_NOT_NULL(expr);
+	TEST_ASSERT_EQUAL_DOUBLE(42.0, EvalExpr(expr, NULL));
+}
+
 void TEST_EvalExpr_ComplicatedExpression_Expected(void)
 {
 	// Arrange
@@ -101,12 +136,221 @@ void TEST_EvalExpr_ComplicatedExpression_Expected(void)
 	double expected_value = 18035.150250378;
 
 	// Act
-	double actual_value = EvalExpr(expr);
+	double actual_value = EvalExpr(expr, NULL);
 
 	// Assert
 	TEST_ASSERT_EQUAL_DOUBLE(expected_value, actual_value);
 }
 
+void TEST_ParseExpression_RepeatedVariable_SameSlot(void)
+{
+	// Arrange, Act
+	Expr *expr = ArrangeExpr("a + b + a");
+
+	// Assert
+	TEST_ASSERT_NOT_NULL(expr);
+	TEST_ASSERT_EQUAL_INT32(EXPR_BINOP, expr->type);
+	Expr *a1 = expr->as.binop.lhs->as.binop.lhs;
+	Expr *b = expr->as.binop.lhs->as.binop.rhs;
+	Expr *a2 = expr->as.binop.rhs;
+	TEST_ASSERT_EQUAL_INT32(EXPR_VARIABLE, a2->type);
+	TEST_ASSERT_EQUAL_INT32(0, a1->as.variable.slot);
+	TEST_ASSERT_EQUAL_INT32(1, b->as.variable.slot);
+	TEST_ASSERT_EQUAL_INT32(0, a2->as.variable.slot);
+	TEST_ASSERT_EQUAL_INT32(2, parser.scope.count);
+}
+
+void TEST_ParseExpression_AssignToNegatedVariable_ParseError(void)
+{
+	// Arrange, Act
+	Expr *expr = ArrangeExpr("-x = 1");
+
+	// Assert
+	TEST_ASSERT_NOT_NULL(expr);
+	TEST_ASSERT_EQUAL_INT32(EXPR_PARSE_ERROR, expr->type);
+}
+
+void TEST_EvalExpr_ChainedAssignment_AllVariablesAssigned(void)
+{
+	// Arrange
+	double variables[2] = {0};
+	Expr *expr = ArrangeExpr("x = y = 2 + 1");
+
+	// Act
+	double actual = EvalExpr(expr, variables);
+
+	// Assert
+	TEST_ASSERT_EQUAL_DOUBLE(3.0, actual);
+	TEST_ASSERT_EQUAL_DOUBLE(3.0, variables[ScopeFind(&parser.scope, "x", 1)]);
+	TEST_ASSERT_EQUAL_DOUBLE(3.0, variables[ScopeFind(&parser.scope, "y", 1)]);
+}
+
+void TEST_EvalExpr_VariableAssignedBeforeReset_ValueKept(void)
+{
+	// Arrange
+	double variables[1] = {0};
+	EvalExpr(ArrangeExpr("answer = 21"), variables);
+	TokenStream ts = TokenStreamFromCStr("2 * answer");
+	ParserReset(&parser, &ts);
+
+	// Act
+	double actual = EvalExpr(ParseExpression(&parser, 0, (Token){TOK_INPUT_END}), variables);
+
+	// Assert
+	TEST_ASSERT_EQUAL_INT32(1, parser.scope.count);
+	TEST_ASSERT_EQUAL_DOUBLE(42.0, actual);
+}
+void TEST_ParseExpression_MillionNestedParentheses_InnerNumberNegated(void)
+{
+	// Arrange
+	const int depth = 1000000;
+	char *input = malloc(3*depth + 2);
+	for (int i = 0; i < depth; ++i) memcpy(input + 2*i, "-(", 2);
+	input[2*depth] = '7';
+	memset(input + 2*depth + 1, ')', depth);
+	input[3*depth + 1] = '\0';
+
+	// Act
+	Expr *expr = ArrangeExpr(input);
+
+	// Assert
+	TEST_ASSERT_NOT_NULL(expr);
+	TEST_ASSERT_EQUAL_INT32(EXPR_NUMBER, expr->type);
+	TEST_ASSERT_EQUAL_INT32(0, expr->flags & EXPR_FLAG_NEGATED);
+	TEST_ASSERT_EQUAL_DOUBLE(7, expr->as.number);
+	free(input);
+}
+
+void TEST_ParseExpression_LongExponentChain_RightAssociative(void)
+{
+	// Arrange
+	const int count = 1000000;
+	char *input = malloc(2*count);
+	for (int i = 0; i < count; ++i) memcpy(input + 2*i, "2^", 2);
+	input[2*count - 1] = '\0';
+
+	// Act
+	Expr *expr = ArrangeExpr(input);
+
+	// Assert
+	int binops = 0;
+	while (expr->type == EXPR_BINOP)
+	{
+		TEST_ASSERT_EQUAL_INT32(EXPR_NUMBER, expr->as.binop.lhs->type);
+		expr = expr->as.binop.rhs;
+		++binops;
+	}
+	TEST_ASSERT_EQUAL_INT32(EXPR_NUMBER, expr->type);
+	TEST_ASSERT_EQUAL_INT32(count - 1, binops);
+	free(input);
+}
+
+void TEST_ParseExpression_UnclosedParenthesis_ErrorAtInputEnd(void)
+{
+	// Arrange, Act
+	Expr *expr = ArrangeExpr("((1 + 2) * 3");
+
+	// Assert
+	TEST_ASSERT_EQUAL_INT32(EXPR_PARSE_ERROR, expr->type);
+	TEST_ASSERT_EQUAL_INT32(0, expr->as.error.line);
+	TEST_ASSERT_EQUAL_INT32(12, expr->as.error.column);
+}
+
+void TEST_FlattenExpr_Binops_OperandsBeforeOperators(void)
+{
+	// Arrange
+	Expr *expr = ArrangeExpr("1 - 2 * (3 + 4)");
+	PostOrder order = {0};
+
+	// Act
+	FlattenExpr(expr, &order);
+
+	// Assert
+	TEST_ASSERT_EQUAL_size_t(7, order.count);
+	TEST_ASSERT_EQUAL_INT32(4, order.maxStackDepth);
+	TEST_ASSERT_EQUAL_PTR(expr, order.nodes[6]);
+	TEST_ASSERT_EQUAL_DOUBLE(1, order.nodes[0]->as.number);
+	TEST_ASSERT_EQUAL_DOUBLE(2, order.nodes[1]->as.number);
+	TEST_ASSERT_EQUAL_DOUBLE(3, order.nodes[2]->as.number);
+	TEST_ASSERT_EQUAL_DOUBLE(4, order.nodes[3]->as.number);
+	TEST_ASSERT_EQUAL_INT32('+', order.nodes[4]->as.binop.op);
+	TEST_ASSERT_EQUAL_INT32('*', order.nodes[5]->as.binop.op);
+	TEST_ASSERT_EQUAL_DOUBLE(-13, EvalPostOrder(&order, NULL));
+	PostOrderFree(&order);
+}
+
+void TEST_EvalExpr_MillionTermLeftLeaningSum_Expected(void)
+{
+	// Arrange
+	const int count = 1000000;
+	char *input = malloc(2*count);
+	for (int i = 0; i < count; ++i) memcpy(input + 2*i, "x+", 2);
+	input[2*count - 1] = '\0';
+	Expr *expr = ArrangeExpr(input);
+	double variables[1] = {0.5};
+
+	// Act
+	double actual = EvalExpr(expr, variables);
+
+	// Assert
+	TEST_ASSERT_EQUAL_DOUBLE(count * 0.5, actual);
+	free(input);
+}
+
+void TEST_EvalExpr_MillionDeepRightNesting_Expected(void)
+{
+	// Arrange
+	const int count = 1000000;
+	char *input = malloc(4*count + 2);
+	for (int i = 0; i < count; ++i) memcpy(input + 3*i, "(1-", 3);
+	input[3*count] = '1';
+	memset(input + 3*count + 1, ')', count);
+	input[4*count + 1] = '\0';
+
+	// Act
+	double actual = EvalExpr(ArrangeExpr(input), NULL);
+
+	// Assert
+	TEST_ASSERT_EQUAL_DOUBLE(1, actual);
+	free(input);
+}
+
+void TEST_PowHalves_SmallExponents_CloseToPow(void)
+{
+	double bases[] = {0.3, 1.7, 2, 10, 123.456, -1.5};
+
+	for (int i = 0; i < (int)(sizeof(bases)/sizeof(*bases)); ++i)
+	{
+		for (int halves = -POW_HALVES_MAX; halves <= POW_HALVES_MAX; ++halves)
+		{
+			// Act
+			double actual = PowHalves(bases[i], halves);
+
+			// Assert
+			double expected = pow(bases[i], halves / 2.0);
+			if (isnan(expected)) TEST_ASSERT_TRUE(isnan(actual));
+			else TEST_ASSERT_DOUBLE_WITHIN(fabs(expected) * 1e-14, expected, actual);
+		}
+	}
+}
+
+void TEST_ExprConstantHalves_Exponents_OnlyHalfIntegersInRange(void)
+{
+	int halves = 0;
+
+	// Act, Assert
+	TEST_ASSERT_TRUE(ExprConstantHalves(ArrangeExpr("-2.5"), &halves));
+	TEST_ASSERT_EQUAL_INT32(-5, halves);
+	ParserRelease(&parser);
+
+	TEST_ASSERT_FALSE(ExprConstantHalves(ArrangeExpr("0.25"), &halves));
+	ParserRelease(&parser);
+
+	TEST_ASSERT_FALSE(ExprConstantHalves(ArrangeExpr("33"), &halves));
+	ParserRelease(&parser);
+
+	TEST_ASSERT_FALSE(ExprConstantHalves(ArrangeExpr("x"), &halves));
+}
 
 int main(void)
 {
@@ -117,6 +361,20 @@ int main(void)
 	RUN_TEST(TEST_ParseExpression_UnaryMinusOnNumber_NegationFlagSet);
 	RUN_TEST(TEST_ParseExpression_UnaryMinusOnParenBinop_NegationFlagSet);
 	RUN_TEST(TEST_ParseExpression_UnaryMinusOnExponent_ExponentNegated);
+	RUN_TEST(TEST_ParseExpression_MissingOperandOnSecondLine_ErrorAtInputEnd);
+	RUN_TEST(TEST_ParserReset_SecondInput_ParsesSecondInput);
 	RUN_TEST(TEST_EvalExpr_ComplicatedExpression_Expected);
+	RUN_TEST(TEST_ParseExpression_RepeatedVariable_SameSlot);
+	RUN_TEST(TEST_ParseExpression_AssignToNegatedVariable_ParseError);
+	RUN_TEST(TEST_EvalExpr_ChainedAssignment_AllVariablesAssigned);
+	RUN_TEST(TEST_EvalExpr_VariableAssignedBeforeReset_ValueKept);
+	RUN_TEST(TEST_ParseExpression_MillionNestedParentheses_InnerNumberNegated);
+	RUN_TEST(TEST_ParseExpression_LongExponentChain_RightAssociative);
+	RUN_TEST(TEST_ParseExpression_UnclosedParenthesis_ErrorAtInputEnd);
+	RUN_TEST(TEST_FlattenExpr_Binops_OperandsBeforeOperators);
+	RUN_TEST(TEST_EvalExpr_MillionTermLeftLeaningSum_Expected);
+	RUN_TEST(TEST_EvalExpr_MillionDeepRightNesting_Expected);
+	RUN_TEST(TEST_PowHalves_SmallExponents_CloseToPow);
+	RUN_TEST(TEST_ExprConstantHalves_Exponents_OnlyHalfIntegersInRange);
 	return UNITY_END();
 }
\ No newline at end of file
@@ -0,0 +1,142 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity.h"
+#include "unity_internals.h"
+#include "../src/tokenizer.h"
+#include "../src/parser.h"
+#include "../src/pipeline.h"
+
+static Parser expectedParser;
+static Parser actualParser;
+static Pipeline pipeline;
+static PipelineStats stats;
+
+void setUp() {}
+void tearDown()
+{
+	ParserRelease(&expectedParser);
+	ParserRelease(&actualParser);
+}
+
+// A sum of termCount products over nameCount names, long enough for many
+// batches.
+static char *GenerateSum(int termCount, int nameCount)
+{
+	size_t capacity = (size_t)termCount * 32 + 1;
+	char *result = malloc(capacity);
+	size_t len = 0;
+
+	for (int i = 0; i < termCount; ++i)
+	{
+		len += snprintf(result + len, capacity - len, "%s%d.5 * v%d\n", i ? " + " : "", i % 10, (i * 7) % nameCount);
+	}
+
+	return result;
+}
+
+static Expr *ParseSequential(const char *input)
+{
+	TokenStream ts = TokenStreamFromCStr(input);
+	ParserInit(&expectedParser, &ts);
+	return ParseExpression(&expectedParser, 0, (Token){TOK_INPUT_END});
+}
+
+static Expr *ParsePipelined(const char *input, bool identViews)
+{
+	TokenStream ts = TokenStreamFromCStr(input);
+	ts.identViews = identViews;
+	actualParser = (Parser){0};
+	TEST_ASSERT_TRUE(PipelineStart(&pipeline, &actualParser, &ts));
+
+	Expr *expr = ParseExpression(&actualParser, 0, (Token){TOK_INPUT_END});
+
+	PipelineFinish(&pipeline, &stats);
+	TEST_ASSERT_NULL(ts.scope);
+	return expr;
+}
+
+void TEST_PipelineStart_LongSum_SameResultAndScopeAsSequentialParse(void)
+{
+	// Arrange
+	char *input = GenerateSum(50000, 3000);
+	Expr *expectedExpr = ParseSequential(input);
+
+	// Act
+	Expr *actualExpr = ParsePipelined(input, false);
+
+	// Assert
+	TEST_ASSERT_EQUAL_INT32(EXPR_BINOP, actualExpr->type);
+	TEST_ASSERT_EQUAL_INT32(expectedParser.scope.count, actualParser.scope.count);
+	for (int i = 0; i < expectedParser.scope.count; ++i)
+	{
+		Ident expectedName = expectedParser.scope.names[i];
+		Ident actualName = actualParser.scope.names[i];
+		TEST_ASSERT_EQUAL_UINT64(expectedName.len, actualName.len);
+		TEST_ASSERT_EQUAL_STRING_LEN(expectedName.chars, actualName.chars, expectedName.len);
+	}
+
+	// Names were copied, so they do not point into the input.
+	TEST_ASSERT_TRUE(actualParser.scope.names[0].chars < input || actualParser.scope.names[0].chars >= input + strlen(input));
+
+	double *expectedVariables = malloc(3000 * sizeof(double));
+	double *actualVariables = malloc(3000 * sizeof(double));
+	for (int i = 0; i < 3000; ++i) expectedVariables[i] = actualVariables[i] = i * 0.25;
+
+	double expected = EvalExpr(expectedExpr, expectedVariables);
+	double actual = EvalExpr(actualExpr, actualVariables);
+	TEST_ASSERT_EQUAL_MEMORY(&expected, &actual, sizeof(double));
+
+	free(expectedVariables);
+	free(actualVariables);
+	free(input);
+}
+
+void TEST_PipelineFinish_LongSum_CountsEveryTokenInFullBatches(void)
+{
+	// Arrange
+	char *input = GenerateSum(20000, 10);
+	ParseSequential(input);
+	size_t tokenCount = expectedParser.tokens.count;
+
+	// Act
+	ParsePipelined(input, true);
+
+	// Assert
+	TEST_ASSERT_EQUAL_UINT64(tokenCount, stats.tokens);
+	TEST_ASSERT_EQUAL_UINT64((tokenCount + PIPELINE_BATCH_TOKENS - 1) / PIPELINE_BATCH_TOKENS, stats.batches);
+	TEST_ASSERT_TRUE(stats.lexSeconds > 0);
+
+	free(input);
+}
+
+void TEST_PipelineFinish_ErrorInFirstBatch_StopsLexerAndReportsLocation(void)
+{
+	// Arrange
+	char *input = GenerateSum(200000, 10);
+	memcpy(input + 40, "* *", 3);
+	Expr *expectedExpr = ParseSequential(input);
+
+	// Act
+	Expr *actualExpr = ParsePipelined(input, true);
+
+	// Assert
+	TEST_ASSERT_EQUAL_INT32(EXPR_PARSE_ERROR, expectedExpr->type);
+	TEST_ASSERT_EQUAL_INT32(EXPR_PARSE_ERROR, actualExpr->type);
+	TEST_ASSERT_EQUAL_STRING(expectedExpr->as.error.message, actualExpr->as.error.message);
+	TEST_ASSERT_EQUAL_INT32(expectedExpr->as.error.line, actualExpr->as.error.line);
+	TEST_ASSERT_EQUAL_INT32(expectedExpr->as.error.column, actualExpr->as.error.column);
+	TEST_ASSERT_LESS_THAN_UINT64(expectedParser.tokens.count, stats.tokens);
+
+	free(input);
+}
+
+int main(void)
+{
+	UNITY_BEGIN();
+	RUN_TEST(TEST_PipelineStart_LongSum_SameResultAndScopeAsSequentialParse);
+	RUN_TEST(TEST_PipelineFinish_LongSum_CountsEveryTokenInFullBatches);
+	RUN_TEST(TEST_PipelineFinish_ErrorInFirstBatch_StopsLexerAndReportsLocation);
+	return UNITY_END();
+}
\ No newline at end of file
@@ -0,0 +1,82 @@
+#include <stdatomic.h>
+
+#include "unity.h"
+#include "unity_internals.h"
+#include "../src/pool.h"
+
+#define TASK_COUNT 1000
+
+static ThreadPool pool;
+static atomic_int runs[TASK_COUNT];
+
+void setUp()
+{
+	for (int i = 0; i < TASK_COUNT; ++i) atomic_store(&runs[i], 0);
+}
+
+void tearDown()
+{
+	PoolRelease(&pool);
+}
+
+static void CountRun(void *context, size_t task)
+{
+	(void)context;
+	atomic_fetch_add(&runs[task], 1);
+}
+
+static void AddTask(void *context, size_t task)
+{
+	atomic_fetch_add((atomic_size_t *)context, task);
+}
+
+void TEST_PoolRun_FourThreads_EveryTaskRunsOnce(void)
+{
+	// Arrange
+	TEST_ASSERT_TRUE(PoolInit(&pool, 4));
+
+	// Act
+	PoolRun(&pool, TASK_COUNT, CountRun, NULL);
+
+	// Assert
+	for (int i = 0; i < TASK_COUNT; ++i) TEST_ASSERT_EQUAL_INT32(1, atomic_load(&runs[i]));
+}
+
+void TEST_PoolRun_ManyJobsInARow_EachJobComplete(void)
+{
+	// Arrange
+	TEST_ASSERT_TRUE(PoolInit(&pool, 3));
+
+	for (size_t taskCount = 0; taskCount < 200; ++taskCount)
+	{
+		atomic_size_t sum = 0;
+
+		// Act
+		PoolRun(&pool, taskCount, AddTask, &sum);
+
+		// Assert
+		TEST_ASSERT_EQUAL_UINT64(taskCount * (taskCount - 1) / 2 * (taskCount > 0), atomic_load(&sum));
+	}
+}
+
+void TEST_PoolRun_SingleThread_RunsOnCaller(void)
+{
+	// Arrange
+	TEST_ASSERT_TRUE(PoolInit(&pool, 1));
+
+	// Act
+	PoolRun(&pool, TASK_COUNT, CountRun, NULL);
+
+	// Assert
+	TEST_ASSERT_EQUAL_INT32(0, pool.threadCount);
+	for (int i = 0; i < TASK_COUNT; ++i) TEST_ASSERT_EQUAL_INT32(1, atomic_load(&runs[i]));
+}
+
+int main(void)
+{
+	UNITY_BEGIN();
+	RUN_TEST(TEST_PoolRun_FourThreads_EveryTaskRunsOnce);
+	RUN_TEST(TEST_PoolRun_ManyJobsInARow_EachJobComplete);
+	RUN_TEST(TEST_PoolRun_SingleThread_RunsOnCaller);
+	return UNITY_END();
+}
\ No newline at end of file
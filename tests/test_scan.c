@@ -0,0 +1,101 @@
+#include <string.h>
+
+#include "unity.h"
+#include "unity_internals.h"
+#include "../src/scan.h"
+
+static const ScanKernel kernels[] = {SCAN_KERNEL_SCALAR, SCAN_KERNEL_SSE2, SCAN_KERNEL_AVX2};
+
+void setUp(){}
+void tearDown()
+{
+	ScanUseKernel(SCAN_KERNEL_AVX2);
+}
+
+void TEST_ScanSpace_LongRunWithNewlines_AllKernelsAgree(void)
+{
+	// Arrange
+	char input[200];
+	memset(input, ' ', sizeof(input));
+	input[3] = '\n';
+	input[40] = '\t';
+	input[70] = '\n';
+	input[71] = '\r';
+	input[150] = '\n';
+	input[170] = 'x';
+	const char *end = input + sizeof(input);
+
+	for (size_t i = 0; i < sizeof(kernels)/sizeof(*kernels); ++i)
+	{
+		ScanUseKernel(kernels[i]);
+
+		// Act
+		const char *stop = ScanSpace(input, end);
+
+		// Assert
+		TEST_ASSERT_EQUAL_PTR(input + 170, stop);
+	}
+}
+
+void TEST_ScanSpace_OnlySpaceToEnd_StopsAtEnd(void)
+{
+	// Arrange
+	char input[77];
+	memset(input, ' ', sizeof(input));
+	const char *end = input + sizeof(input);
+
+	for (size_t i = 0; i < sizeof(kernels)/sizeof(*kernels); ++i)
+	{
+		ScanUseKernel(kernels[i]);
+
+		// Act
+		const char *stop = ScanSpace(input, end);
+
+		// Assert
+		TEST_ASSERT_EQUAL_PTR(end, stop);
+	}
+}
+
+void TEST_ScanDigits_LongLiteral_AllKernelsStopAtRadixPoint(void)
+{
+	// Arrange
+	const char *input = "12345678901234567890123456789012345678901234567890.5";
+
+	for (size_t i = 0; i < sizeof(kernels)/sizeof(*kernels); ++i)
+	{
+		ScanUseKernel(kernels[i]);
+
+		// Act
+		const char *stop = ScanDigits(input, input + strlen(input));
+
+		// Assert
+		TEST_ASSERT_EQUAL_PTR(input + 50, stop);
+	}
+}
+
+void TEST_ScanDigits_HighBitCharacters_NotDigits(void)
+{
+	// Arrange
+	const char input[] = "12\xb0\xb9" "0123456789012345678901234567890123";
+
+	for (size_t i = 0; i < sizeof(kernels)/sizeof(*kernels); ++i)
+	{
+		ScanUseKernel(kernels[i]);
+
+		// Act
+		const char *stop = ScanDigits(input, input + sizeof(input) - 1);
+
+		// Assert
+		TEST_ASSERT_EQUAL_PTR(input + 2, stop);
+	}
+}
+
+int main(void)
+{
+	UNITY_BEGIN();
+	RUN_TEST(TEST_ScanSpace_LongRunWithNewlines_AllKernelsAgree);
+	RUN_TEST(TEST_ScanSpace_OnlySpaceToEnd_StopsAtEnd);
+	RUN_TEST(TEST_ScanDigits_LongLiteral_AllKernelsStopAtRadixPoint);
+	RUN_TEST(TEST_ScanDigits_HighBitCharacters_NotDigits);
+	return UNITY_END();
+}
@@ -0,0 +1,115 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "unity.h"
+#include "unity_internals.h"
+#include "../src/scope.h"
+
+static Scope scope;
+
+void setUp() {}
+void tearDown()
+{
+	ScopeFree(&scope);
+}
+
+void TEST_ScopeSlot_RepeatedName_SameSymbolAndOneCopy(void)
+{
+	// Arrange
+	const char input[] = "x + x*y - x";
+
+	// Act
+	Symbol first = ScopeSlot(&scope, input, 1);
+	Symbol y = ScopeSlot(&scope, input + 6, 1);
+	Symbol second = ScopeSlot(&scope, input + 10, 1);
+
+	// Assert
+	TEST_ASSERT_EQUAL_INT32(0, first);
+	TEST_ASSERT_EQUAL_INT32(1, y);
+	TEST_ASSERT_EQUAL_INT32(first, second);
+	TEST_ASSERT_EQUAL_INT32(2, scope.count);
+	TEST_ASSERT_EQUAL_STRING("x", scope.names[first].chars);
+}
+
+void TEST_ScopeFind_UnknownName_MinusOne(void)
+{
+	// Arrange
+	ScopeSlot(&scope, "price", 5);
+
+	// Act, Assert
+	TEST_ASSERT_EQUAL_INT32(-1, ScopeFind(&scope, "pric", 4));
+	TEST_ASSERT_EQUAL_INT32(-1, ScopeFind(&scope, "prices", 6));
+	TEST_ASSERT_EQUAL_INT32(0, ScopeFind(&scope, "price", 5));
+}
+
+void TEST_ScopeFind_EmptyScope_MinusOne(void)
+{
+	// Act, Assert
+	TEST_ASSERT_EQUAL_INT32(-1, ScopeFind(&scope, "x", 1));
+}
+
+void TEST_ScopeSlot_ManyNames_NumberedInOrderAndAllFound(void)
+{
+	// Arrange
+	char name[16];
+	const int count = 10000;
+
+	// Act
+	for (int i = 0; i < count; ++i)
+	{
+		int len = sprintf(name, "v%d", i);
+		TEST_ASSERT_EQUAL_INT32(i, ScopeSlot(&scope, name, len));
+	}
+
+	// Assert
+	TEST_ASSERT_EQUAL_INT32(count, scope.count);
+	TEST_ASSERT_TRUE(scope.bucketCount >= 2*(size_t)count);
+	for (int i = count - 1; i >= 0; --i)
+	{
+		int len = sprintf(name, "v%d", i);
+		TEST_ASSERT_EQUAL_INT32(i, ScopeFind(&scope, name, len));
+		TEST_ASSERT_EQUAL_STRING(name, scope.names[i].chars);
+	}
+}
+
+void TEST_ScopeSlotView_NewName_PointsIntoInput(void)
+{
+	// Arrange
+	const char input[] = "rate * time";
+
+	// Act
+	Symbol rate = ScopeSlotView(&scope, input, 4);
+	Symbol time = ScopeSlotView(&scope, input + 7, 4);
+
+	// Assert
+	TEST_ASSERT_EQUAL_PTR(input, scope.names[rate].chars);
+	TEST_ASSERT_EQUAL_PTR(input + 7, scope.names[time].chars);
+	TEST_ASSERT_EQUAL_size_t(4, scope.names[time].len);
+}
+
+void TEST_ScopeSlotView_NameAlreadyCopied_SameSymbolCopyKept(void)
+{
+	// Arrange
+	const char input[] = "x";
+	Symbol copied = ScopeSlot(&scope, input, 1);
+
+	// Act
+	Symbol viewed = ScopeSlotView(&scope, input, 1);
+
+	// Assert
+	TEST_ASSERT_EQUAL_INT32(copied, viewed);
+	TEST_ASSERT_NOT_EQUAL(input, scope.names[viewed].chars);
+	TEST_ASSERT_EQUAL_STRING("x", scope.names[viewed].chars);
+}
+
+int main(void)
+{
+	UNITY_BEGIN();
+	RUN_TEST(TEST_ScopeSlot_RepeatedName_SameSymbolAndOneCopy);
+	RUN_TEST(TEST_ScopeFind_UnknownName_MinusOne);
+	RUN_TEST(TEST_ScopeFind_EmptyScope_MinusOne);
+	RUN_TEST(TEST_ScopeSlot_ManyNames_NumberedInOrderAndAllFound);
+	RUN_TEST(TEST_ScopeSlotView_NewName_PointsIntoInput);
+	RUN_TEST(TEST_ScopeSlotView_NameAlreadyCopied_SameSymbolCopyKept);
+	return UNITY_END();
+}
\ No newline at end of file
@@ -0,0 +1,101 @@
+#include <string.h>
+
+#include "unity.h"
+#include "unity_internals.h"
+#include "../src/table.h"
+
+static Table table;
+
+void setUp() {}
+void tearDown()
+{
+	TableFree(&table);
+}
+
+static bool ArrangeCsv(const char *csv)
+{
+	return TableFromCsv(csv, strlen(csv), &table);
+}
+
+void TEST_TableFromCsv_HeaderAndRows_ValuesByColumn(void)
+{
+	// Arrange, Act
+	bool loaded = ArrangeCsv(" x , y_2\n1, -2.5\n\n3,4e2\r\n.5 ,+6");
+
+	// Assert
+	TEST_ASSERT_TRUE(loaded);
+	TEST_ASSERT_EQUAL_INT32(2, table.columnCount);
+	TEST_ASSERT_EQUAL_UINT64(3, table.rowCount);
+	TEST_ASSERT_EQUAL_INT32(1, TableFindColumn(&table, "y_2", 3));
+	TEST_ASSERT_EQUAL_INT32(-1, TableFindColumn(&table, "y", 1));
+
+	const double *x = TableColumn(&table, 0);
+	const double *y = TableColumn(&table, 1);
+	TEST_ASSERT_EQUAL_DOUBLE(1, x[0]);
+	TEST_ASSERT_EQUAL_DOUBLE(3, x[1]);
+	TEST_ASSERT_EQUAL_DOUBLE(0.5, x[2]);
+	TEST_ASSERT_EQUAL_DOUBLE(-2.5, y[0]);
+	TEST_ASSERT_EQUAL_DOUBLE(400, y[1]);
+	TEST_ASSERT_EQUAL_DOUBLE(6, y[2]);
+}
+
+void TEST_TableFromCsv_MissingValue_Fails(void)
+{
+	// Arrange, Act
+	bool loaded = ArrangeCsv("a,b\n1,2\n3\n");
+
+	// Assert
+	TEST_ASSERT_FALSE(loaded);
+	TEST_ASSERT_NULL(table.values);
+}
+
+void TEST_TableFromCsv_NotANumber_Fails(void)
+{
+	// Arrange, Act
+	bool loaded = ArrangeCsv("a\n1x\n");
+
+	// Assert
+	TEST_ASSERT_FALSE(loaded);
+}
+
+void TEST_TableFromBinary_TwoRows_TransposedToColumns(void)
+{
+	// Arrange
+	double rows[] = {1, 2, 3, 4, 5, 6};
+	char data[64] = "a,b,c\n";
+	size_t headerLen = strlen(data);
+	memcpy(data + headerLen, rows, sizeof(rows));
+
+	// Act
+	bool loaded = TableFromBinary(data, headerLen + sizeof(rows), &table);
+
+	// Assert
+	TEST_ASSERT_TRUE(loaded);
+	TEST_ASSERT_EQUAL_UINT64(2, table.rowCount);
+	TEST_ASSERT_EQUAL_DOUBLE(4, TableColumn(&table, 0)[1]);
+	TEST_ASSERT_EQUAL_DOUBLE(3, TableColumn(&table, 2)[0]);
+}
+
+void TEST_TableFromBinary_PartialRow_Fails(void)
+{
+	// Arrange
+	char data[64] = "a,b\n";
+	size_t len = strlen(data) + 3 * sizeof(double);
+
+	// Act
+	bool loaded = TableFromBinary(data, len, &table);
+
+	// Assert
+	TEST_ASSERT_FALSE(loaded);
+}
+
+int main(void)
+{
+	UNITY_BEGIN();
+	RUN_TEST(TEST_TableFromCsv_HeaderAndRows_ValuesByColumn);
+	RUN_TEST(TEST_TableFromCsv_MissingValue_Fails);
+	RUN_TEST(TEST_TableFromCsv_NotANumber_Fails);
+	RUN_TEST(TEST_TableFromBinary_TwoRows_TransposedToColumns);
+	RUN_TEST(TEST_TableFromBinary_PartialRow_Fails);
+	return UNITY_END();
+}
\ No newline at end of file
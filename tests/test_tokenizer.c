@@ -1,3 +1,5 @@
+#include <stdlib.h>
+
 #include "unity.h"
 #include "unity_internals.h"
 #include "../src/tokenizer.h"
@@ -48,6 +50,51 @@ void TEST_NextToken_NumberInInput_MatchingNumberToken(void)
 	TEST_ASSERT_EQUAL_DOUBLE(42, token.as.number);
 }
 
+void TEST_NextToken_IdentifierFollowedByOperator_OperatorNotConsumed(void)
+{
+	// Arrange
+	Scope scope = {0};
+	TokenStream ts = TokenStreamFromCStr("x_1=y");
+	ts.scope = &scope;
+
+	// Act
+	Token tokX = NextToken(&ts);
+	Token tokAssign = NextToken(&ts);
+	Token tokY = NextToken(&ts);
+	Token tokEnd = NextToken(&ts);
+
+	// Assert
+	TEST_ASSERT_EQUAL_INT32(TOK_IDENT, tokX.type);
+	TEST_ASSERT_EQUAL_STRING("x_1", scope.names[tokX.as.ident].chars);
+	TEST_ASSERT_EQUAL_INT32('=', tokAssign.type);
+	TEST_ASSERT_EQUAL_INT32(TOK_IDENT, tokY.type);
+	TEST_ASSERT_EQUAL_STRING("y", scope.names[tokY.as.ident].chars);
+	TEST_ASSERT_EQUAL_INT32(TOK_INPUT_END, tokEnd.type);
+
+	ScopeFree(&scope);
+}
+
+void TEST_NextToken_IdentViews_NamesPointIntoInput(void)
+{
+	// Arrange
+	const char *input = "speed*speed";
+	Scope scope = {0};
+	TokenStream ts = TokenStreamFromCStr(input);
+	ts.scope = &scope;
+	ts.identViews = true;
+
+	// Act
+	Token first = NextToken(&ts);
+	NextToken(&ts);
+	Token second = NextToken(&ts);
+
+	// Assert
+	TEST_ASSERT_EQUAL_INT32(first.as.ident, second.as.ident);
+	TEST_ASSERT_EQUAL_PTR(input, scope.names[first.as.ident].chars);
+	TEST_ASSERT_EQUAL_size_t(5, scope.names[first.as.ident].len);
+
+	ScopeFree(&scope);
+}
 
 void TEST_NextToken_CharactersBetween1And255_TokenTypeEqualsCharacterOrdinalValue(void)
 {
@@ -76,10 +123,193 @@ void TEST_NextToken_SeveralLinesAndColumns_ExpectedLineAndColumn(void)
 
 	// Act
 	Token token = NextToken(&ts);
+	int line, column;
+	TokenStreamLocation(&ts, token.offset, &line, &column);
+
+	// Assert
+	TEST_ASSERT_EQUAL_UINT64(5, token.offset);
+	TEST_ASSERT_EQUAL_INT32(expectedLine, line);
+	TEST_ASSERT_EQUAL_INT32(expectedColumn, column);
+}
+
+void TEST_LexTokens_ExpressionInput_AllTokensEndingWithInputEnd(void)
+{
+	// Arrange
+	TokenStream ts = TokenStreamFromCStr("1 +\n 2");
+
+	// Act
+	TokenBuffer buffer = {0};
+	LexTokens(&ts, &buffer);
+
+	// Assert
+	TEST_ASSERT_EQUAL_UINT64(4, buffer.count);
+	TEST_ASSERT_EQUAL_INT32(TOK_NUMBER, buffer.tokens[0].type);
+	TEST_ASSERT_EQUAL_INT32('+', buffer.tokens[1].type);
+	TEST_ASSERT_EQUAL_INT32(TOK_NUMBER, buffer.tokens[2].type);
+	TEST_ASSERT_EQUAL_INT32(TOK_INPUT_END, buffer.tokens[3].type);
+
+	int line, column;
+	TokenBufferLocation(&buffer, buffer.tokens[2].offset, &line, &column);
+	TEST_ASSERT_EQUAL_INT32(1, line);
+	TEST_ASSERT_EQUAL_INT32(1, column);
+
+	TokenBufferFree(&buffer);
+}
+
+void TEST_LexTokens_NumbersAndIdentifiers_EightByteTokensWithValuesInSideArrays(void)
+{
+	// Arrange
+	Scope scope = {0};
+	TokenStream ts = TokenStreamFromCStr("x = 1.5 * y - x / 2");
+	ts.scope = &scope;
+
+	// Act
+	TokenBuffer buffer = {0};
+	LexTokens(&ts, &buffer);
+
+	// Assert
+	TEST_ASSERT_EQUAL_size_t(8, sizeof(PackedToken));
+	TEST_ASSERT_EQUAL_UINT64(10, buffer.count);
+	TEST_ASSERT_EQUAL_INT32('*', buffer.tokens[3].type);
+	TEST_ASSERT_EQUAL_UINT32(8, buffer.tokens[3].offset);
+
+	TEST_ASSERT_EQUAL_UINT64(2, buffer.numberCount);
+	TEST_ASSERT_EQUAL_DOUBLE(1.5, buffer.numbers[0]);
+	TEST_ASSERT_EQUAL_DOUBLE(2, buffer.numbers[1]);
+
+	TEST_ASSERT_EQUAL_UINT64(3, buffer.identCount);
+	TEST_ASSERT_EQUAL_INT32(0, buffer.idents[0]);
+	TEST_ASSERT_EQUAL_INT32(1, buffer.idents[1]);
+	TEST_ASSERT_EQUAL_INT32(0, buffer.idents[2]);
+
+	TokenBufferFree(&buffer);
+	ScopeFree(&scope);
+}
+
+void TEST_LexTokens_StreamStartingMidLine_SameOffsetsAndLocationsAsNextToken(void)
+{
+	// Arrange
+	const char *input = "1 +\n  2 * 3\n\n   4";
+	TokenStream ts = TokenStreamFromCStr(input);
+	NextToken(&ts);
+	NextToken(&ts);
+	TokenStream expected = ts;
+	static const int expectedLines[] = {1, 1, 1, 3, 3};
+	static const int expectedColumns[] = {2, 4, 6, 3, 4};
+
+	// Act
+	TokenBuffer buffer = {0};
+	LexTokens(&ts, &buffer);
+
+	// Assert
+	TEST_ASSERT_EQUAL_UINT64(5, buffer.count);
+
+	for (size_t i = 0; i < buffer.count; ++i)
+	{
+		Token token = NextToken(&expected);
+		int line, column;
+		TokenBufferLocation(&buffer, buffer.tokens[i].offset, &line, &column);
+
+		TEST_ASSERT_EQUAL_INT32(token.type, buffer.tokens[i].type);
+		TEST_ASSERT_EQUAL_UINT64(token.offset, buffer.tokens[i].offset);
+		TEST_ASSERT_EQUAL_INT32(expectedLines[i], line);
+		TEST_ASSERT_EQUAL_INT32(expectedColumns[i], column);
+	}
+
+	TokenBufferFree(&buffer);
+}
+
+void TEST_LexTokenBatch_MoreTokensThanBatch_ContinuesWhereLastBatchStopped(void)
+{
+	// Arrange
+	TokenStream ts = TokenStreamFromCStr("1 + 2 * 3");
+	TokenBuffer buffer = {0};
+
+	// Act
+	bool firstEnded = LexTokenBatch(&ts, &buffer, 3);
+	size_t firstCount = buffer.count;
+	uint32_t firstOffset = buffer.tokens[0].offset;
+	bool secondEnded = LexTokenBatch(&ts, &buffer, 3);
+
+	// Assert
+	TEST_ASSERT_FALSE(firstEnded);
+	TEST_ASSERT_EQUAL_UINT64(3, firstCount);
+	TEST_ASSERT_EQUAL_UINT32(0, firstOffset);
+
+	TEST_ASSERT_TRUE(secondEnded);
+	TEST_ASSERT_EQUAL_UINT64(3, buffer.count);
+	TEST_ASSERT_EQUAL_INT32('*', buffer.tokens[0].type);
+	TEST_ASSERT_EQUAL_UINT32(6, buffer.tokens[0].offset);
+	TEST_ASSERT_EQUAL_UINT64(1, buffer.numberCount);
+	TEST_ASSERT_EQUAL_DOUBLE(3, buffer.numbers[0]);
+	TEST_ASSERT_EQUAL_INT32(TOK_INPUT_END, buffer.tokens[2].type);
+
+	TokenBufferFree(&buffer);
+}
+
+void TEST_NextToken_DeepIndentationOverSeveralLines_ExpectedLineAndColumn(void)
+{
+	// Arrange
+	TokenStream ts = TokenStreamFromCStr("1\n                                \n\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t  2");
+	NextToken(&ts);
+
+	// Act
+	Token token = NextToken(&ts);
+	int line, column;
+	TokenStreamLocation(&ts, token.offset, &line, &column);
+
+	// Assert
+	TEST_ASSERT_EQUAL_INT32(TOK_NUMBER, token.type);
+	TEST_ASSERT_EQUAL_INT32(2, line);
+	TEST_ASSERT_EQUAL_INT32(42, column);
+}
+
+void TEST_NextToken_BytesFrom128Up_OperatorTokens(void)
+{
+	for (int c = 128; c < 256; ++c)
+	{
+		// Arrange
+		char input[] = {(char)c, 'x', '\0'};
+		Scope scope = {0};
+		TokenStream ts = TokenStreamFromCStr(input);
+		ts.scope = &scope;
+
+		// Act
+		Token token = NextToken(&ts);
+		Token next = NextToken(&ts);
+
+		// Assert
+		TEST_ASSERT_EQUAL_INT32((char)c, token.type);
+		TEST_ASSERT_EQUAL_INT32(TOK_IDENT, next.type);
+		TEST_ASSERT_EQUAL_UINT64(1, scope.names[next.as.ident].len);
+		ScopeFree(&scope);
+	}
+}
+
+void TEST_NextToken_UnderscoresAndDigits_ContinueButDoNotStartIdentifier(void)
+{
+	// Arrange
+	Scope scope = {0};
+	TokenStream ts = TokenStreamFromCStr("_a a_1_ 2b");
+	ts.scope = &scope;
+
+	// Act
+	Token underscore = NextToken(&ts);
+	Token a = NextToken(&ts);
+	Token a1 = NextToken(&ts);
+	Token two = NextToken(&ts);
+	Token b = NextToken(&ts);
 
 	// Assert
-	TEST_ASSERT_EQUAL_INT32(expectedLine, token.line);
-	TEST_ASSERT_EQUAL_INT32(expectedColumn, token.column);
+	TEST_ASSERT_EQUAL_INT32('_', underscore.type);
+	TEST_ASSERT_EQUAL_INT32(TOK_IDENT, a.type);
+	TEST_ASSERT_EQUAL_INT32(TOK_IDENT, a1.type);
+	TEST_ASSERT_EQUAL_STRING_LEN("a_1_", scope.names[a1.as.ident].chars, 4);
+	TEST_ASSERT_EQUAL_UINT64(4, scope.names[a1.as.ident].len);
+	TEST_ASSERT_EQUAL_INT32(TOK_NUMBER, two.type);
+	TEST_ASSERT_EQUAL_INT32(TOK_IDENT, b.type);
+	TEST_ASSERT_EQUAL_INT32(TOK_INPUT_END, NextToken(&ts).type);
+	ScopeFree(&scope);
 }
 
 int main(void)
@@ -89,7 +319,16 @@ int main(void)
 	RUN_TEST(TEST_TokenStreamFromCStr_InputOfLength13_EndAtStartPlus13);
 	RUN_TEST(TEST_NextToken_EmptyInput_EmptyOutput);
 	RUN_TEST(TEST_NextToken_NumberInInput_MatchingNumberToken);
+	RUN_TEST(TEST_NextToken_IdentifierFollowedByOperator_OperatorNotConsumed);
+	RUN_TEST(TEST_NextToken_IdentViews_NamesPointIntoInput);
 	RUN_TEST(TEST_NextToken_CharactersBetween1And255_TokenTypeEqualsCharacterOrdinalValue);
 	RUN_TEST(TEST_NextToken_SeveralLinesAndColumns_ExpectedLineAndColumn);
+	RUN_TEST(TEST_NextToken_DeepIndentationOverSeveralLines_ExpectedLineAndColumn);
+	RUN_TEST(TEST_LexTokens_ExpressionInput_AllTokensEndingWithInputEnd);
+	RUN_TEST(TEST_LexTokens_NumbersAndIdentifiers_EightByteTokensWithValuesInSideArrays);
+	RUN_TEST(TEST_LexTokens_StreamStartingMidLine_SameOffsetsAndLocationsAsNextToken);
+	RUN_TEST(TEST_LexTokenBatch_MoreTokensThanBatch_ContinuesWhereLastBatchStopped);
+	RUN_TEST(TEST_NextToken_BytesFrom128Up_OperatorTokens);
+	RUN_TEST(TEST_NextToken_UnderscoresAndDigits_ContinueButDoNotStartIdentifier);
 	return UNITY_END();
 }
\ No newline at end of file